@@ -26,4 +26,8 @@ include( systemc )
 # Simplify life
 add_compile_definitions( SC_INCLUDE_FX SC_INCLUDE_DYNAMIC_PROCESSES )
 
+# Background writers (e.g. debug/trace_file.cpp) use std::thread
+find_package( Threads REQUIRED )
+link_libraries( Threads::Threads )
+
 # vim:nospell
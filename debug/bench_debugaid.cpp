@@ -0,0 +1,288 @@
+// Microbenchmarks for the per-call overhead of the debug support library, so
+// the cost of Debug, REPORT_*, Info, Objection, Timer and Profiler calls in hot code can
+// be quantified (and checked for regressions) before adopting them.
+//
+// Each case runs in batches sized to take at least --dMinTime seconds
+// (default 0.1), repeated --nRepeats times (default 5). The median
+// nanoseconds per call is the result; the fastest batch is shown alongside.
+//
+//   bench_debugaid [--sFilter=TEXT] [--sJson=FILE] [--sBaseline=FILE] [--dTolerance=PCT]
+//
+// --sFilter=TEXT    only runs cases whose name contains TEXT
+// --sJson=FILE      writes the results as JSON, sorted by name, one per line
+// --sBaseline=FILE  compares with an earlier --sJson and exits with 1 if any
+//                   case is more than --dTolerance percent (default 25) slower
+//
+// Reports that pass the verbosity filter go to a msg_type whose actions are
+// SC_DO_NOTHING, so the report handler is measured rather than the terminal.
+
+#include "debug.hpp"
+#include "objection.hpp"
+#include "profiler.hpp"
+#include "timer.hpp"
+#include <systemc>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <regex>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace {
+
+using namespace sc_core;
+using namespace std::literals;
+
+// Stop the compiler from discarding a result that is otherwise unused
+template<typename T>
+inline void keep( const T& value )
+{
+#if defined(__GNUC__) or defined(__clang__)
+  asm volatile( "" : : "g"( &value ) : "memory" );
+#else
+  static const void* volatile sink;
+  sink = &value;
+#endif
+}
+
+struct Result {
+  std::string name;
+  double      median{};     // ns per call
+  double      fastest{};    // ns per call
+  size_t      iterations{}; // per batch
+};
+
+using Body = std::function<void( size_t )>; // performs the call n times
+
+Result measure( const std::string& name, const Body& body, double min_time, size_t repeats )
+{
+  using clock = std::chrono::steady_clock;
+  auto batch = [&body]( size_t n ) {
+    auto start = clock::now();
+    body( n );
+    return std::chrono::duration<double>( clock::now() - start ).count();
+  };
+  body( 1 ); // first use may intern names, allocate or print a disclaimer
+  size_t n = 1;
+  auto elapsed = batch( n );
+  while( elapsed < min_time ) {
+    auto scale = ( elapsed > 0.0 ) ? std::min( 10.0, 1.2 * min_time / elapsed ) : 10.0;
+    n = std::max( n + 1, static_cast<size_t>( static_cast<double>( n ) * scale ) );
+    elapsed = batch( n );
+  }
+  auto per_call = std::vector<double>{ 1e9 * elapsed / static_cast<double>( n ) };
+  while( per_call.size() < std::max<size_t>( repeats, 1 ) ) {
+    per_call.push_back( 1e9 * batch( n ) / static_cast<double>( n ) );
+  }
+  std::sort( per_call.begin(), per_call.end() );
+  return { name, per_call[ per_call.size() / 2 ], per_call.front(), n };
+}
+
+std::string to_json( const std::vector<Result>& results )
+{
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(3);
+  os << "{\n"
+     << "  \"benchmark\": \"bench_debugaid\",\n"
+     << "  \"unit\": \"ns/call\",\n"
+     << "  \"results\": [\n";
+  for( size_t i = 0; i < results.size(); ++i ) {
+    const auto& r{ results[i] };
+    os << "    { \"name\": \"" << r.name << "\", \"median\": " << r.median
+       << ", \"fastest\": " << r.fastest << ", \"iterations\": " << r.iterations << " }"
+       << ( ( i + 1 < results.size() ) ? "," : "" ) << "\n";
+  }
+  os << "  ]\n}\n";
+  return os.str();
+}
+
+// Reads the medians back from a file written by to_json()
+std::map<std::string, double> read_baseline( const std::string& filename )
+{
+  auto result = std::map<std::string, double>{};
+  auto file = std::ifstream{ filename };
+  static const auto entry = std::regex{ R"re("name":\s*"([^"]+)",\s*"median":\s*([-+0-9.eE]+))re" };
+  auto line = ""s;
+  while( std::getline( file, line ) ) {
+    std::smatch match;
+    if( std::regex_search( line, match, entry ) ) {
+      result[ match[1] ] = std::stod( match[2] );
+    }
+  }
+  return result;
+}
+
+}//endnamespace
+
+struct Bench_module : sc_module
+{
+  static constexpr const char* quiet_type = "/Doulos/bench_debugaid/quiet"; // SC_DO_NOTHING
+  Doulos::Info info{ quiet_type };
+  std::vector<Result> results{};
+
+  explicit Bench_module( const sc_module_name& instance )
+    : sc_module( instance )
+  {
+    SC_HAS_PROCESS( Bench_module );
+    SC_THREAD( bench_thread );
+    sc_report_handler::set_actions( quiet_type, SC_DO_NOTHING );
+    Debug::parse_command_line();
+  }
+
+  void run( const std::string& name, const Body& body )
+  {
+    auto filter = Debug::get_text( "sFilter" );
+    if( not filter.empty() and name.find( filter ) == std::string::npos ) return;
+    auto min_time = Debug::parsed( "dMinTime" ) ? Debug::get_value( "dMinTime" ) : 0.1;
+    auto repeats  = Debug::parsed( "nRepeats" ) ? Debug::get_count( "nRepeats" ) : size_t{ 5 };
+    results.push_back( measure( name, body, min_time, repeats ) );
+  }
+
+  void bench_thread()
+  {
+    auto saved_verbosity = sc_report_handler::get_verbosity_level();
+    Debug::set_count( "nBench", 42 );
+
+    //--------------------------------------------------------------------------
+    run( "debug/get_count", []( size_t n ) {
+      for( size_t i = 0; i < n; ++i ) keep( Debug::get_count( "nBench" ) );
+    } );
+    run( "debug/debugging", []( size_t n ) {
+      for( size_t i = 0; i < n; ++i ) keep( Debug::debugging() );
+    } );
+    run( "debug/injecting", []( size_t n ) {
+      for( size_t i = 0; i < n; ++i ) keep( Debug::injecting( 2 ) );
+    } );
+
+    //--------------------------------------------------------------------------
+    // REPORT_* expand to one of these, depending on whether fmt is available
+    for( auto shown : { false, true } ) {
+      auto suffix = shown ? "/shown"s : "/filtered"s;
+      sc_report_handler::set_verbosity_level( shown ? SC_DEBUG : SC_MEDIUM );
+      run( "report/text" + suffix, []( size_t n ) { // fallback, e.g. REPORT_DEBUG(mesg)
+        for( size_t i = 0; i < n; ++i ) {
+          REPORT_INFO_VERB( quiet_type, Doulos::text( "value "s + std::to_string( i ), SC_INFO, SC_DEBUG ), SC_DEBUG );
+        }
+      } );
+#ifdef REPORT_FORMAT
+      run( "report/format" + suffix, []( size_t n ) { // e.g. REPORT_DEBUG("value {}",i)
+        for( size_t i = 0; i < n; ++i ) {
+          REPORT_VERB_FORMAT( quiet_type, SC_DEBUG, "value {}", i );
+        }
+      } );
+#endif
+      run( "report/sc_report" + suffix, []( size_t n ) { // arguments always evaluated
+        for( size_t i = 0; i < n; ++i ) {
+          SC_REPORT_INFO_VERB( quiet_type, Doulos::text( "value "s + std::to_string( i ), SC_INFO, SC_DEBUG ), SC_DEBUG );
+        }
+      } );
+    }
+    sc_report_handler::set_verbosity_level( saved_verbosity );
+
+    //--------------------------------------------------------------------------
+    run( "info/mark", [this]( size_t n ) { // always shown (SC_NONE)
+      for( size_t i = 0; i < n; ++i ) info.mark( "Bench", "bench_thread", this );
+    } );
+
+    //--------------------------------------------------------------------------
+    // Hold an objection throughout so the drops never start the drain
+    Objection::Category busy{ "bench" };
+    Objection::Scope<Objection::Category> holding{ busy };
+    run( "objection/named", []( size_t n ) {
+      for( size_t i = 0; i < n; ++i ) Objection bench{ "bench_named", SC_DEBUG, true };
+    } );
+    run( "objection/category", [&busy]( size_t n ) {
+      for( size_t i = 0; i < n; ++i ) Objection::Scope<Objection::Category> bench{ busy };
+    } );
+
+    //--------------------------------------------------------------------------
+    run( "timer/construct", []( size_t n ) {
+      for( size_t i = 0; i < n; ++i ) {
+        Timer timer{ "bench", false };
+        keep( timer );
+      }
+    } );
+    Timer timer{ "bench", false };
+    run( "timer/elapsed", [&timer]( size_t n ) {
+      for( size_t i = 0; i < n; ++i ) keep( timer.elapsed() );
+    } );
+    run( "report/time_stamp", []( size_t n ) {
+      for( size_t i = 0; i < n; ++i ) keep( Doulos::time_stamp() );
+    } );
+
+    //--------------------------------------------------------------------------
+    run( "profiler/zone", []( size_t n ) { // nested, as zones usually are
+      PROFILE_ZONE( "bench" );
+      for( size_t i = 0; i < n; ++i ) {
+        PROFILE_ZONE( "zone" );
+      }
+    } );
+
+    std::sort( results.begin(), results.end()
+             , []( const Result& lhs, const Result& rhs ){ return lhs.name < rhs.name; } );
+    sc_stop();
+  }
+};
+
+int sc_main( [[maybe_unused]] int argc, [[maybe_unused]] char* argv[] )
+{
+  auto bench = std::make_unique<Bench_module>( "bench" );
+  sc_start();
+
+  auto baseline = Debug::parsed( "sBaseline" ) ? read_baseline( Debug::get_text( "sBaseline" ) )
+                                               : std::map<std::string, double>{};
+  auto tolerance = Debug::parsed( "dTolerance" ) ? Debug::get_value( "dTolerance" ) : 25.0;
+  auto slower = 0;
+  std::cout << "\n" << std::left << std::setw(28) << "benchmark" << std::right
+            << std::setw(12) << "ns/call" << std::setw(12) << "fastest" << std::setw(12) << "iterations";
+  if( not baseline.empty() ) std::cout << std::setw(12) << "baseline" << std::setw(10) << "change";
+  std::cout << "\n" << std::fixed << std::setprecision(2);
+  for( const auto& r : bench->results ) {
+    std::cout << std::left << std::setw(28) << r.name << std::right
+              << std::setw(12) << r.median << std::setw(12) << r.fastest << std::setw(12) << r.iterations;
+    auto before = baseline.find( r.name );
+    if( before != baseline.end() and before->second > 0.0 ) {
+      auto change = 100.0 * ( r.median - before->second ) / before->second;
+      std::cout << std::setw(12) << before->second << std::setw(9) << std::showpos << change << std::noshowpos << '%';
+      if( change > tolerance ) {
+        std::cout << "  SLOWER";
+        ++slower;
+      }
+    }
+    else if( not baseline.empty() ) {
+      std::cout << std::setw(12) << "-" << std::setw(10) << "new";
+    }
+    std::cout << "\n";
+  }
+
+  if( Debug::parsed( "sJson" ) ) {
+    auto filename = Debug::get_text( "sJson" );
+    auto file = std::ofstream{ filename };
+    file << to_json( bench->results );
+    std::cout << ( file ? "Wrote " : "Unable to write " ) << filename << "\n";
+  }
+  if( Debug::parsed( "sBaseline" ) ) {
+    if( baseline.empty() ) {
+      std::cout << "No results found in baseline " << Debug::get_text( "sBaseline" ) << "\n";
+      return 1;
+    }
+    std::cout << slower << " benchmark(s) more than " << tolerance << "% slower than baseline\n";
+  }
+  if( not Profiler::statistics().empty() ) {
+    Profiler::report();
+  }
+  return ( slower == 0 ) ? 0 : 1;
+}
+
+// TAGS: Doulos, SystemC, performance, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
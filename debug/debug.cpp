@@ -1,8 +1,29 @@
 #include "debug.hpp"
+#include "trace_file.hpp"
+#include "tx_recorder.hpp"
+#include "perf_counters.hpp"
+#include "objection.hpp"
+#include "chronout.hpp"
 #include <fstream>
 #include <sstream>
 #include <string>
+#include <string_view>
+#include <algorithm>
 #include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <deque>
+#include <iomanip>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <unordered_map>
+#if __has_include(<sys/resource.h>)
+#include <sys/resource.h>
+#endif
 using namespace sc_core;
 using namespace sc_dt;
 using namespace std::literals;
@@ -19,23 +40,40 @@ EXECUTABLE --help
 | Option            | Description                                               |
 | ----------------- | --------------------------------------------------------- |
 | `--config FILE`   | Set verbosity to `SC_DEBUG`                               |
-| `--dNAME=DOUBLE`  | Set NAMEd double to DOUBLE (e.g., -dPi=3.14159 )          |
+| `--dNAME=DOUBLE`  | Set NAMEd double to DOUBLE (e.g., --dPi=3.14159 )         |
 | `--debug [MASK]`  | Set verbosity to `SC_DEBUG`                               |
-| `--expect=N`      | Expect N errors                                           |
+| `--expect=N[:TYPE]` | Expect N errors (optionally only from msg_type TYPE)    |
+| `--fail-fast`     | Stop as soon as expectations can no longer be met         |
 | `--debug [MASK]`  | Set verbosity to `SC_DEBUG`                               |
 | `--fNAME=BOOLEAN` | Set NAMEd flag true or false (e.g., --fTest=true)         |
 | `--help`          | This text                                                 |
 | `--inject [MASK]` | Intentionally inject errors                               |
+| `--max-deltas-per-step=N` | Stop if one time step runs more than N delta cycles |
+| `--max-wall=SECONDS` | Stop after SECONDS of wall-clock time (m/h suffix ok)  |
 | `--nNAME=COUNT`   | Set NAMEd count to COUNT (`size_t`)                       |
 | `--no-config`     | Do not read default configuration file (must be first)    |
 | `--no-debug`      | Set verbosity to `SC_MEDIUM`                              |
 | `--no-inject`     | Turn off injection if set                                 |
+| `--no-report-handler` | Do not install the expectation counting report handler |
 | `--no-trace`      | Turn off trace if set                                     |
 | `--no-verbose`    | Set verbosity to `SC_MEDIUM`                              |
+| `--perf[=PATS]`   | Count cycles, instructions, cache & branch misses per phase (and in processes matching PATS) |
+| `--perf-db[=FILE]` | Compare wall time, speed, peak RSS & report count with earlier runs in FILE (default: perf.db), then append |
+| `--perf-gate=PCT` | Fail if any `--perf-db` metric is more than PCT percent worse than the baseline |
 | `--quiet`         | Set verbosity to `SC_LOW`                                 |
+| `--record [FILE]` | Record transactions to FILE.txr (default: transactions)   |
 | `--sNAME=TEXT`    | Set NAMEd string to TEXT (e.g., -sFile="data.txt")        |
 | `--tNAME=TIME`    | Set NAMEd time to TIME value (e.g., `10_ns`)              |
 | `--trace [FILE]`  | Trace signals to dump FILE (default: dump)                |
+| `--trace-format=F` | Waveform format F: `vcd` (default), `avcd`, `bin`, `delta` |
+| `--trace-from=TIME` | Start tracing at TIME (default: 0)                      |
+| `--trace-include=PATS` | Only trace objects matching comma-separated PATS     |
+| `--trace-signals[=PATS]` | Trace all signals & ports matching PATS (default: `**`) |
+| `--trace-cache=FILE` | Reuse/save the signals found by `--trace-signals` in FILE |
+| `--trace-segment=TIME` | Start a new trace segment every TIME (not plain vcd) |
+| `--trace-segment-size=BYTES` | Start a new trace segment after BYTES (K/M/G suffix ok) |
+| `--trace-exclude=PATS` | Do not trace objects matching comma-separated PATS   |
+| `--trace-to=TIME` | Stop tracing at TIME (default: end of simulation)         |
 | `--verbose`| `-v` | Set verbosity to `SC_HIGH` if not debugging               |
 | `--warn`          | Warn on any unrecognized command-line switches            |
 | `--werror`        | Treat warnings as errors (stop after parsing)             |
@@ -43,7 +81,16 @@ EXECUTABLE --help
 In above:
 
 - `--no-config` must be the first option specified
-- Trace FILE's will have .vcd appended automatically.
+- Trace FILE's will have .vcd (or .bin, .dlt) appended automatically. Use `trace2vcd FILE.bin` to view binary traces.
+- Trace format `avcd` writes the same VCD as `vcd`, but formats it on a background thread; `bin` is smaller still.
+- Trace format `delta` records changes in every delta cycle to FILE.dlt; `trace2vcd FILE.dlt` shows delta d of a step d pseudo-time units after it.
+- Trace segments are named FILE.bin, FILE-0001.bin, ..., and FILE.idx lists `file time_fs byte_offset` for every block (about every MiB for `avcd`).
+- Trace PATS match dotted hierarchical names (e.g., `top.m1.*`) using `*` within one level, `**` across levels, and select everything beneath a matching name. Only objects registered via `Debug::trace()` are filtered.
+- Recorded transactions are begun and ended by the design via `Debug::recorder()` (see tx_recorder.hpp). Use `txr2csv FILE.txr` to list and summarize them.
+- The watchdog (`--max-wall`, `--max-deltas-per-step`) reports time, delta, how long time has stalled and the last process reported through `Info`, then stops gracefully and fails `exit_status()`. If a process never yields, it prints the current process and exits after a grace period.
+- `--perf` uses Linux perf_event_open; if counters are unavailable (e.g., containers or VMs) it says why and carries on. Processes are counted between `Info::entering`/`resuming` and `Info::yielding`/`leaving`.
+- `--perf-db` keys runs by executable name and options (other than `--perf-db`/`--perf-gate`), and compares with the median of the last 5 matching runs. Runs that fail or regress are not recorded, so the baseline does not drift. Short runs are noisy; pick PCT accordingly.
+- Expected TYPE may use `*` to match one `/`-separated level of msg_type, or `**` for any number of levels (e.g., `/Doulos/*/consumer`).
 - NAMEd items retain the prefix in the internal name. Thus `--nReps` maps to `count("nReps")`.
 - COUNT is unsigned (use a small DOUBLE if you need signed).
 - MASK is a numeric and different bits can be used.
@@ -74,6 +121,16 @@ Many methods are inline and static.
 | `void Debug::breakpoint( const string& tag )`                         | subroutine to set breakpoint explicitly (for use in GDB)          |
 | `void Debug::stop_if_requested()`                                     | issues `sc_top()` if requested via `s_stop()`                     |
 | `void Debug::set_trace_file( const string& filename )`                | sets the trace file                                               |
+| `void Debug::set_trace_format( const string& format )`                | selects `"vcd"`, `"avcd"`, `"bin"` or `"delta"` for later files   |
+| `void Debug::set_record_file( const string& filename )`               | records transactions to filename.txr (empty closes)               |
+| `Doulos::Tx_recorder* Debug::recorder()`                              | returns the transaction recorder or nullptr if not recording      |
+| `void Debug::set_perf_counters( bool enable, processes = {} )`        | reads hardware counters per phase and in matching processes       |
+| `void Debug::set_perf_db( const string& filename, double gate = 0 )` | compares with & appends to a baseline file in `exit_status()`     |
+| `Doulos::Perf_counters* Debug::perf_counters()`                       | returns the hardware counters or nullptr if unavailable/disabled  |
+| `void Debug::set_trace_window( filename, from, until = max )`         | opens filename at from and closes it at until                     |
+| `void Debug::trace( const T& object, name, const sc_object* scope )`  | `sc_trace` subject to trace patterns and window                   |
+| `bool Debug::trace_selected( const string& path )`                    | returns true if path passes the trace patterns                    |
+| `size_t Debug::trace_signals( patterns = {"**"}, cache = "" )`        | traces every signal & port of a built-in type matching patterns   |
 | `void Debug::set_quiet( bool flag = true )`                           | selects quiet output                                              |
 | `void Debug::set_verbose( bool flag = true )`                         | selects verbose output                                            |
 | `void Debug::set_debugging( const mask_t& mask = 1 )`                 | enables debugging                                                 |
@@ -83,7 +140,12 @@ Many methods are inline and static.
 | `void Debug::set_time( const string& name, const sc_time& time = 0 )` | sets the named time                                               |
 | `void Debug::set_flag( const string& name, bool flag = true )`        | sets the named flag                                               |
 | `void add_expected( sc_severity level, string msg_type, ssize_t n)`   | sets expectations for `n` messages of specified `severity`        |
-| `void see_expected( sc_severity level, string msg_type_)`             | use this in `report_handler` if checking msg_type of expected     |
+|                                                                       | (msg_type may contain `*` and `**` wildcards)                     |
+| `void add_expected( level, msg_type, n, at_most, from, until )`       | as above, but at most `at_most` and only within [from,until)      |
+| `void set_fail_fast( bool flag = true )`                              | `sc_stop()` as soon as expectations cannot be met                 |
+| `void set_watchdog( double max_wall, size_t max_deltas = 0 )`         | `sc_stop()` after max_wall seconds or max_deltas in one step      |
+| `void see_expected( sc_severity level, string msg_type_)`             | records an observation (only needed with `--no-report-handler`)   |
+| `void set_report_handler( bool install = true )`                      | installs/removes the chaining handler that calls `see_expected`   |
 | `ssize_t get_expected( sc_severity level = max_severity )`            | returns total number of expected messages of severity or all      |
 | `ssize_t get_observed( sc_severity level = max_severity )`            | returns total number of observed messages of severity or all      |
 | `void Debug::help()`                                                  | displays this text (for use in GDB)                               |
@@ -161,6 +223,17 @@ EXECUTABLE -nReps=20 --trace --debug --inject
         inout.replace(pos, what.length(), with.data(), with.length());
   }
 
+  // Appends each comma-separated item of list to patterns
+  void append_patterns( const string& list, std::vector<string>& patterns )
+  {
+    for( auto pos = size_t{}; pos <= list.length(); ) {
+      auto end = list.find_first_of( ',', pos );
+      if( end == npos ) end = list.length();
+      if( end > pos ) patterns.push_back( list.substr( pos, end - pos ) );
+      pos = end + 1;
+    }
+  }
+
   string verbosity_offset( int base )
   {
     auto result = ""s;
@@ -210,6 +283,8 @@ void Info::mark( const std::string& action_name
                , const std::string& what
                )
 {
+  auto process = sc_get_current_process_handle();
+  if( process.valid() ) Debug::s_last_process() = process.name();
   REPORT_INFO_VERB( context()
                   , Doulos::text( action_name + " "s + func + " "s
                                   + Debug::get_simulation_info( obj, what )
@@ -221,17 +296,19 @@ void Info::mark( const std::string& action_name
 void Info::executed( const std::string& func, sc_object* obj, const std::string& what  )
    { mark( "Executed"s, func + "()", obj, what ); }
 
+// With --perf=PATS, a matching process is counted from entering/resuming
+// until yielding/leaving (the mark itself is excluded)
 void Info::entering( const std::string& func, sc_object* obj, const std::string& what )
-   { mark( "Entering"s, func + "()", obj, what ); }
+   { mark( "Entering"s, func + "()", obj, what ); Debug::s_perf_process( true ); }
 
 void Info::yielding( const std::string& func, sc_object* obj, const std::string& what )
-   { mark( "Yielding"s, func + "()", obj, what ); }
+   { Debug::s_perf_process( false ); mark( "Yielding"s, func + "()", obj, what ); }
 
 void Info::resuming( const std::string& func, sc_object* obj, const std::string& what )
-   { mark( "Resuming"s, func + "()", obj, what ); }
+   { mark( "Resuming"s, func + "()", obj, what ); Debug::s_perf_process( true ); }
 
 void Info::leaving( const std::string& func, sc_object* obj, const std::string& what )
-   { mark( "Leaving"s, func + "()", obj, what ); }
+   { Debug::s_perf_process( false ); mark( "Leaving"s, func + "()", obj, what ); }
 
 }//endnamespace Doulos
 
@@ -250,7 +327,7 @@ std::string Debug::get_simulation_info( sc_object* obj, const std::string& what
   if ( time_is_valid ) {
     // time
     if ( what.find_first_of("tT") != npos  ) {
-      result += " at "s + sc_time_stamp().to_string();
+      result += " at "s + Doulos::time_stamp();
     }
     // delta cycle
     if ( what.find_first_of("dD") != npos ) {
@@ -312,6 +389,8 @@ void Debug::read_configuration( args_t& args, string filename ) {
 //..............................................................................
 void Debug::parse_command_line() {
   auto& args{ config() };
+  set_report_handler();
+  s_install_hooks();
   if( ( sc_argc() == 1 ) or ( ( sc_argc() > 1 ) and ( string{ sc_argv()[1] } != "--no-config" ) ) ) {
     // Read default configuration file if it exists
     read_configuration( args );
@@ -322,6 +401,7 @@ void Debug::parse_command_line() {
   }
   // Parse args
   auto pos = size_t{};
+  auto trace_name = string{};
   for ( auto i = 0u; i < args.size(); ++i ) {
     auto arg = args[i];
     SC_REPORT_INFO_VERB( msg_type, ("Processing "s + arg).c_str(), SC_HIGH );
@@ -385,6 +465,90 @@ void Debug::parse_command_line() {
       }
     }
     //--------------------------------------------------------------------------
+    // Handle --dName=DOUBLE
+    //..........................................................................
+    else if ( ( arg.substr(0,3) == "--d" )
+            and ( (pos=arg.find_first_of('=')) != npos )
+            and ( pos > 3 )
+            and ( pos + 1 < arg.length() )
+            )
+    {
+      auto name = arg.substr( 2, pos - 2 );
+      auto value = arg.substr( pos+1 );
+      replace_all( value, "_", "" );
+      replace_all( value, "'", "" );
+      char* end = nullptr;
+      auto number = std::strtod( value.c_str(), &end );
+      if ( value.empty() or *end != '\0' ) {
+        if( s_warn() )
+          REPORT_WARNING( "Ignoring incorrectly specified command-line argument "s + arg );
+        continue;
+      }
+      s_parsed(name);
+      s_value(name) = number;
+    }
+    //--------------------------------------------------------------------------
+    // Handle --trace-include=PATTERNS and --trace-exclude=PATTERNS
+    // Note: --trace-from=TIME and --trace-to=TIME are handled as --tName=TIME
+    //..........................................................................
+    else if ( ( arg.substr(0,16) == "--trace-include=" )
+              or ( arg.substr(0,16) == "--trace-exclude=" )
+            )
+    {
+      append_patterns( arg.substr( 16 ), ( arg[8] == 'i' ) ? s_trace_include() : s_trace_exclude() );
+      s_parsed( arg.substr( 2, 13 ) );
+    }
+    //--------------------------------------------------------------------------
+    // Handle --trace-signals[=PATTERNS] and --trace-cache=FILE
+    //..........................................................................
+    else if ( ( arg == "--trace-signals" ) or ( arg.substr(0,16) == "--trace-signals=" ) ) {
+      append_patterns( ( arg.length() > 16 ) ? arg.substr( 16 ) : "**"s, s_trace_signals() );
+      s_parsed("trace-signals");
+    }
+    else if ( ( arg.substr(0,14) == "--trace-cache=" ) and ( arg.length() > 14 ) ) {
+      s_parsed("trace-cache");
+      s_text("trace-cache") = arg.substr( 14 );
+    }
+    //--------------------------------------------------------------------------
+    // Handle --trace-segment-size=BYTES[K|M|G]
+    // Note: --trace-segment=TIME is handled as --tName=TIME
+    //..........................................................................
+    else if ( arg.substr(0,21) == "--trace-segment-size=" ) {
+      auto value = lowercase( arg.substr( 21 ) );
+      replace_all( value, "_", "" );
+      replace_all( value, "'", "" );
+      auto scale = size_t{1};
+      if( not value.empty() ) {
+        switch( value.back() ) {
+          case 'k': scale = size_t{1} << 10; break;
+          case 'm': scale = size_t{1} << 20; break;
+          case 'g': scale = size_t{1} << 30; break;
+          default: break;
+        }
+        if( scale != 1 ) value.pop_back();
+      }
+      if( value.empty() or value.find_first_not_of("0123456789") != npos ) {
+        if( s_warn() )
+          REPORT_WARNING( "Ignoring incorrectly specified command-line argument "s + arg );
+        continue;
+      }
+      s_parsed("trace-segment-size");
+      s_count("trace-segment-size") = std::stoul(value) * scale;
+    }
+    //--------------------------------------------------------------------------
+    // Handle --trace-format=FORMAT (must precede --tName=TIME)
+    //..........................................................................
+    else if ( arg.substr(0,15) == "--trace-format=" ) {
+      auto format = lowercase( arg.substr( 15 ) );
+      if( format != "vcd" and format != "avcd" and format != "bin" and format != "delta" ) {
+        if( s_warn() )
+          REPORT_WARNING( "Ignoring incorrectly specified command-line argument "s + arg );
+        continue;
+      }
+      s_parsed("trace-format");
+      set_trace_format( format );
+    }
+    //--------------------------------------------------------------------------
     // Handle --tName=TIME
     //..........................................................................
     else if ( ( arg.substr(0,3) == "--t" )
@@ -438,6 +602,13 @@ void Debug::parse_command_line() {
       s_text(name) = arg.substr(pos+1);
     }
     //--------------------------------------------------------------------------
+    // Handle --fail-fast (before --fName, which would otherwise take it)
+    //..........................................................................
+    else if ( arg == "--fail-fast" ) {
+      s_parsed("fail-fast");
+      set_fail_fast();
+    }
+    //--------------------------------------------------------------------------
     // Handle --fName=BOOLEAN
     //..........................................................................
     else if ( ( arg.substr(0,3) == "--f" )
@@ -528,7 +699,34 @@ void Debug::parse_command_line() {
         }
       }
       s_parsed("trace");
-      set_trace_file( dump_name );
+      trace_name = dump_name; // opened after parsing so --trace-format may follow
+    }
+    //--------------------------------------------------------------------------
+    // Handle --record
+    //..........................................................................
+    else if ( arg == "--record"  ) {
+      auto record_name = "transactions"s;
+      if( i+1 < args.size() and args[i+1][0] != '-' ) {
+        record_name = args[++i];
+        pos = record_name.find_first_of("/\\:");
+        if( pos == npos ) {
+          pos = 0;
+        }
+        pos = record_name.find_first_of( '.', pos );
+        if( pos != npos ) {
+          record_name.erase( pos ); // Remove extension
+        }
+      }
+      s_parsed("record");
+      set_record_file( record_name );
+    }
+    //--------------------------------------------------------------------------
+    // Handle --no-trace
+    //..........................................................................
+    else if ( arg == "--no-trace" ) {
+      s_parsed("no-trace");
+      trace_name.clear();
+      close_trace_file();
     }
     //--------------------------------------------------------------------------
     // Handle --quiet
@@ -570,7 +768,7 @@ void Debug::parse_command_line() {
       set_debugging(0);
     }
     //--------------------------------------------------------------------------
-    // Handle --nName=COUNT
+    // Handle --expect=COUNT[:MSG_TYPE]
     //..........................................................................
     else if ( ( arg.substr(0,8) == "--expect" )
               and ( (pos=arg.find_first_of('=')) != npos )
@@ -579,6 +777,11 @@ void Debug::parse_command_line() {
             )
     {
       auto expected = arg.substr( pos+1 );
+      auto expected_type = ""s;
+      if( (pos=expected.find_first_of(':')) != npos ) {
+        expected_type = expected.substr( pos+1 );
+        expected.erase( pos );
+      }
       replace_all( expected, "_", "" );
       replace_all( expected, "'", "" );
       if ( ( expected.find_first_of("0123456789") == 0 )
@@ -587,7 +790,7 @@ void Debug::parse_command_line() {
       {
         s_parsed("expect");
         REPORT_STR(expected);
-        add_expected(SC_ERROR,"",std::stoi(expected));
+        add_expected(SC_ERROR,expected_type,std::stoi(expected));
       }
       else {
         if( s_warn() )
@@ -614,6 +817,76 @@ void Debug::parse_command_line() {
       set_injecting( 0 );
     }
     //--------------------------------------------------------------------------
+    // Handle --max-wall=SECONDS
+    //..........................................................................
+    else if ( arg.substr(0,11) == "--max-wall=" ) {
+      auto value = lowercase( arg.substr( 11 ) );
+      auto scale = 1.0;
+      if( not value.empty() ) {
+        switch( value.back() ) {
+          case 's':                 value.pop_back(); break;
+          case 'm': scale = 60.0;   value.pop_back(); break;
+          case 'h': scale = 3600.0; value.pop_back(); break;
+          default: break;
+        }
+      }
+      if( value.find_first_of("0123456789") == npos or value.find_first_not_of(".0123456789") != npos ) {
+        if( s_warn() )
+          REPORT_WARNING( "Ignoring incorrectly specified command-line argument "s + arg );
+        continue;
+      }
+      s_parsed("max-wall");
+      s_value("max-wall") = std::stod(value) * scale;
+    }
+    //--------------------------------------------------------------------------
+    // Handle --max-deltas-per-step=N
+    //..........................................................................
+    else if ( arg.substr(0,22) == "--max-deltas-per-step=" ) {
+      auto value = arg.substr( 22 );
+      if( value.empty() or value.find_first_not_of("0123456789") != npos ) {
+        if( s_warn() )
+          REPORT_WARNING( "Ignoring incorrectly specified command-line argument "s + arg );
+        continue;
+      }
+      s_parsed("max-deltas-per-step");
+      s_count("max-deltas-per-step") = std::stoul(value);
+    }
+    //--------------------------------------------------------------------------
+    // Handle --perf-db[=FILE]
+    //..........................................................................
+    else if ( ( arg == "--perf-db" ) or ( arg.substr(0,10) == "--perf-db=" ) ) {
+      s_parsed("perf-db");
+      s_text("perf-db") = ( arg.length() > 10 ) ? arg.substr( 10 ) : "perf.db"s;
+    }
+    //--------------------------------------------------------------------------
+    // Handle --perf-gate=PCT
+    //..........................................................................
+    else if ( arg.substr(0,12) == "--perf-gate=" ) {
+      auto value = arg.substr( 12 );
+      if( not value.empty() and value.back() == '%' ) value.pop_back();
+      if( value.find_first_of("0123456789") == npos or value.find_first_not_of(".0123456789") != npos ) {
+        if( s_warn() )
+          REPORT_WARNING( "Ignoring incorrectly specified command-line argument "s + arg );
+        continue;
+      }
+      s_parsed("perf-gate");
+      s_value("perf-gate") = std::stod(value);
+    }
+    //--------------------------------------------------------------------------
+    // Handle --perf[=PATTERNS]
+    //..........................................................................
+    else if ( ( arg == "--perf" ) or ( arg.substr(0,7) == "--perf=" ) ) {
+      s_parsed("perf");
+      if( arg.length() > 7 ) append_patterns( arg.substr( 7 ), s_perf_patterns() );
+    }
+    //--------------------------------------------------------------------------
+    // Handle --no-report-handler
+    //..........................................................................
+    else if ( arg == "--no-report-handler" ) {
+      s_parsed("no-report-handler");
+      set_report_handler( false );
+    }
+    //--------------------------------------------------------------------------
     // Handle --warn
     //..........................................................................
     else if ( arg == "--warn" ) {
@@ -652,6 +925,25 @@ void Debug::parse_command_line() {
       REPORT_WARNING( "Ignoring unknown command-line argument "s + arg );
     }
   }
+  if( not trace_name.empty() ) {
+    set_trace_window( trace_name
+                    , parsed("trace-from") ? get_time("trace-from") : SC_ZERO_TIME
+                    , parsed("trace-to")   ? get_time("trace-to")   : sc_max_time()
+                    );
+  }
+  if( parsed("perf") ) {
+    set_perf_counters( true, s_perf_patterns() );
+  }
+  if( parsed("perf-db") or parsed("perf-gate") ) {
+    set_perf_db( parsed("perf-db") ? get_text("perf-db") : "perf.db"s
+               , parsed("perf-gate") ? get_value("perf-gate") : 0.0
+               );
+  }
+  if( parsed("max-wall") or parsed("max-deltas-per-step") ) {
+    set_watchdog( parsed("max-wall") ? get_value("max-wall") : 0.0
+                , parsed("max-deltas-per-step") ? get_count("max-deltas-per-step") : 0
+                );
+  }
   //----------------------------------------------------------------------------
   // Abort if --werror requested and warnings encountered
   //............................................................................
@@ -681,20 +973,800 @@ void Debug::stop_if_requested() {
 void Debug::set_trace_file( const string& filename ) {
   if( ( not filename.empty() ) and ( filename == s_trace_name() ) ) return;
   if( s_trace_file() != nullptr ) {
-    sc_close_vcd_trace_file( s_trace_file() );
+    auto custom = dynamic_cast<Doulos::Trace_file*>( s_trace_file() );
+    auto closed = ( custom != nullptr ) ? string{ custom->filename() } : s_trace_name() + ".vcd"s;
+    if( custom != nullptr ) {
+      delete custom; // drains and joins the writer thread
+    }
+    else {
+      sc_close_vcd_trace_file( s_trace_file() );
+    }
+    s_trace_file() = nullptr;
     SC_REPORT_INFO_VERB( msg_type,
-                         ( "Closed trace file '"s + s_trace_name() + ".vcd'"s ).c_str(),
+                         ( "Closed trace file '"s + closed + "'"s ).c_str(),
                          SC_NONE
                        );
+    s_trace_name().clear();
   }
   if( filename.length() != 0 ) {
     s_trace_name() = filename;
-    s_trace_file() = sc_create_vcd_trace_file( filename.c_str() );
+    auto segment_time = parsed("trace-segment")      ? get_time("trace-segment")       : SC_ZERO_TIME;
+    auto segment_size = parsed("trace-segment-size") ? get_count("trace-segment-size") : size_t{0};
+    Doulos::Trace_file* custom = nullptr;
+    if( s_trace_format() == "bin" ) {
+      custom = new Doulos::Bin_trace_file( filename.c_str() );
+    }
+    else if( s_trace_format() == "avcd" ) {
+      custom = new Doulos::Vcd_trace_file( filename.c_str() );
+    }
+    else if( s_trace_format() == "delta" ) {
+      custom = new Doulos::Delta_trace_file( filename.c_str() );
+    }
+    if( custom != nullptr ) {
+      custom->set_segments( segment_time, segment_size );
+      s_trace_file() = custom;
+    }
+    else {
+      s_trace_file() = sc_create_vcd_trace_file( filename.c_str() );
+      if( segment_time != SC_ZERO_TIME or segment_size != 0 ) {
+        REPORT_WARNING( "Trace segments require --trace-format=bin, avcd or delta; writing a single file"s );
+      }
+    }
+    auto extension = ( s_trace_format() == "bin" ) ? ".bin"s : ( s_trace_format() == "delta" ) ? ".dlt"s : ".vcd"s;
+    SC_REPORT_INFO_VERB( msg_type,
+                         ( "Tracing to '"s + s_trace_name() + extension + "'"s ).c_str(),
+                         SC_NONE
+                       );
+    for( auto& [path, registration] : s_trace_registrations() ) {
+      registration( s_trace_file() );
+    }
+  }
+  else {
+    s_trace_pending().clear(); // also cancels a window that has not started
+  }
+}
+
+//..............................................................................
+// Opens and closes a trace window just before simulated time reaches its
+// bounds. Only time steps are seen (never delta cycles) and nothing is
+// scheduled, so a window never keeps sc_start() running after the model has
+// gone quiet; exit_status() closes a file still open at the end.
+#if SYSTEMC_VERSION >= 20181013
+struct Debug::Trace_window : sc_stage_callback_if
+{
+  Trace_window( const string& filename_, const sc_time& from_, const sc_time& until_ )
+  : filename{ filename_ }, from{ from_ }, until{ until_ }, opened{ from_ <= sc_time_stamp() }
+  {
+    sc_register_stage_callback( *this, SC_PRE_TIMESTEP );
+  }
+
+  // Called with the time step that is about to start still pending
+  void stage_callback( const sc_stage& ) override
+  {
+    if( done ) return; // unregistering from within a callback is not allowed
+    auto next = sc_time_stamp() + sc_time_to_pending_activity();
+    if( not opened and next >= from ) {
+      opened = true;
+      if( s_trace_pending() != filename ) { // closed before it started
+        done = true;
+        return;
+      }
+      s_trace_pending().clear();
+      set_trace_file( filename );
+    }
+    if( opened and next >= until ) {
+      if( s_trace_name() == filename ) {
+        close_trace_file();
+      }
+      done = true;
+    }
+  }
+
+  string  filename;
+  sc_time from;
+  sc_time until;
+  bool    opened;
+  bool    done{ false };
+};
+#else
+// Older kernels lack stage callbacks, so a process follows the model's own
+// activity instead, waking every delta cycle until the window closes.
+struct Debug::Trace_window
+{
+  Trace_window( const string& filename, const sc_time& from, const sc_time& until )
+  {
+    sc_spawn( [filename,from,until]()
+    {
+      if( from > sc_time_stamp() ) {
+        auto started = wait_for_activity_until( from );
+        if( s_trace_pending() != filename ) return; // closed before it started
+        s_trace_pending().clear();
+        if( not started ) return; // nothing left to trace
+        set_trace_file( filename );
+      }
+      wait_for_activity_until( until );
+      if( s_trace_name() == filename ) {
+        close_trace_file();
+      }
+    }, sc_gen_unique_name( "trace_window" ) );
+  }
+
+  // Returns false if the model went quiet before at
+  static bool wait_for_activity_until( const sc_time& at )
+  {
+    while( sc_time_stamp() < at ) {
+      if( not sc_pending_activity() ) return false;
+      auto next = sc_time_to_pending_activity(); // zero while deltas are pending
+      wait( std::min( next, at - sc_time_stamp() ) );
+    }
+    return true;
+  }
+};
+#endif
+
+void Debug::set_trace_window( const string& filename, const sc_time& from, const sc_time& until ) {
+  if( until <= from ) {
+    REPORT_WARNING( "Ignoring empty trace window for '"s + filename + "'"s );
+    return;
+  }
+  if( from <= sc_time_stamp() ) {
+    set_trace_file( filename );
+    if( until == sc_max_time() ) return;
+  }
+  else {
+    s_trace_pending() = filename;
+  }
+  new Trace_window{ filename, from, until }; // lives as long as the simulation
+}
+
+//..............................................................................
+namespace {
+  // Glob on dotted names: '*' and '?' stay within one level, "**" spans levels
+  bool glob_match( string_view pattern, string_view text ) {
+    if( pattern.empty() ) return text.empty();
+    if( pattern.substr( 0, 2 ) == "**" ) {
+      for( size_t i = 0; i <= text.size(); ++i ) {
+        if( glob_match( pattern.substr( 2 ), text.substr( i ) ) ) return true;
+      }
+      return false;
+    }
+    if( pattern[0] == '*' ) {
+      for( size_t i = 0; i <= text.size(); ++i ) {
+        if( glob_match( pattern.substr( 1 ), text.substr( i ) ) ) return true;
+        if( i < text.size() and text[i] == '.' ) break;
+      }
+      return false;
+    }
+    if( text.empty() ) return false;
+    if( pattern[0] == '?' ? text[0] == '.' : pattern[0] != text[0] ) return false;
+    return glob_match( pattern.substr( 1 ), text.substr( 1 ) );
+  }
+  // A pattern selects a path if it matches the path or any of its ancestors
+  bool hierarchy_match( const string& pattern, const string& path ) {
+    for( auto end = path.find( '.' ); ; end = path.find( '.', end + 1 ) ) {
+      if( glob_match( pattern, string_view{ path }.substr( 0, end ) ) ) return true;
+      if( end == string::npos ) return false;
+    }
+  }
+}//endnamespace
+
+bool Debug::trace_selected( const string& path ) {
+  auto matches = [&path]( const args_t& patterns ) {
+    return std::any_of( patterns.begin(), patterns.end()
+                      , [&path]( const string& pattern ){ return hierarchy_match( pattern, path ); }
+                      );
+  };
+  if( not s_trace_include().empty() and not matches( s_trace_include() ) ) return false;
+  return not matches( s_trace_exclude() );
+}
+
+//..............................................................................
+namespace {
+  // Signal value types that sc_trace supports directly. Ports are traced via
+  // the channel they are bound to.
+  template<typename T>
+  bool trace_signal( sc_object* object, bool probe ) {
+    auto interface = dynamic_cast<const sc_interface*>( object );
+    if( auto port = dynamic_cast<const sc_port_base*>( object ); port != nullptr ) {
+      interface = port->get_interface();
+    }
+    auto signal = dynamic_cast<const sc_signal_in_if<T>*>( interface );
+    if( signal == nullptr ) return false;
+    if( not probe ) Debug::trace( *signal, object->name() );
+    return true;
+  }
+  struct Traceable {
+    const char* type;
+    bool (*trace)( sc_object* object, bool probe ); // false if object is not of type
+  };
+  const Traceable traceable[] = {
+    { "bool",     trace_signal<bool>               },
+    { "logic",    trace_signal<sc_logic>           },
+    { "char",     trace_signal<char>               },
+    { "uchar",    trace_signal<unsigned char>      },
+    { "short",    trace_signal<short>              },
+    { "ushort",   trace_signal<unsigned short>     },
+    { "int",      trace_signal<int>                },
+    { "uint",     trace_signal<unsigned int>       },
+    { "long",     trace_signal<long>               },
+    { "ulong",    trace_signal<unsigned long>      },
+    { "int64",    trace_signal<sc_dt::int64>       },
+    { "uint64",   trace_signal<sc_dt::uint64>      },
+    { "float",    trace_signal<float>              },
+    { "double",   trace_signal<double>             },
+    { "time",     trace_signal<sc_time>            },
+  };
+  using Resolved = std::vector<std::pair<const Traceable*, sc_object*>>;
+  void find_signals( sc_object* object, const Debug::args_t& patterns, Resolved& found ) {
+    auto path = string{ object->name() };
+    if( std::any_of( patterns.begin(), patterns.end()
+                   , [&path]( const string& pattern ){ return hierarchy_match( pattern, path ); } ) )
+    {
+      for( const auto& candidate : traceable ) {
+        if( candidate.trace( object, true ) ) {
+          found.emplace_back( &candidate, object );
+          break;
+        }
+      }
+    }
+    for( auto child : object->get_child_objects() ) find_signals( child, patterns, found );
+  }
+  // A port traces the channel it is bound to, so keep one entry per channel,
+  // preferring the channel's own name
+  void drop_duplicates( Resolved& found ) {
+    auto seen = std::set<const sc_interface*>{};
+    for( const auto& [kind, object] : found ) {
+      if( dynamic_cast<const sc_port_base*>( object ) != nullptr ) continue;
+      if( auto channel = dynamic_cast<const sc_interface*>( object ); channel != nullptr ) seen.insert( channel );
+    }
+    found.erase( std::remove_if( found.begin(), found.end(), [&seen]( const auto& entry ) {
+      auto port = dynamic_cast<const sc_port_base*>( entry.second );
+      return port != nullptr and not seen.insert( port->get_interface() ).second;
+    } ), found.end() );
+  }
+  // Object count and FNV-1a hash of every name, so a cache is not reused
+  // after objects are added to (or removed from) the design
+  void hash_hierarchy( const sc_object* object, size_t& count, std::uint64_t& hash ) {
+    ++count;
+    for( auto name = object->name(); *name != '\0'; ++name ) {
+      hash = ( hash ^ static_cast<unsigned char>( *name ) ) * 0x100000001b3ull;
+    }
+    hash = ( hash ^ '\n' ) * 0x100000001b3ull;
+    for( auto child : object->get_child_objects() ) hash_hierarchy( child, count, hash );
+  }
+  string hierarchy_signature() {
+    auto count = size_t{ 0 };
+    auto hash = std::uint64_t{ 0xcbf29ce484222325ull };
+    for( auto object : sc_get_top_level_objects() ) hash_hierarchy( object, count, hash );
+    std::ostringstream os;
+    os << "[" << count << " objects " << std::hex << hash << "]";
+    return os.str();
+  }
+}//endnamespace
+
+size_t Debug::trace_signals( const args_t& patterns, const string& cache ) {
+  if( not tracing() ) return 0;
+  auto signature = "# trace-signals"s;
+  for( const auto& pattern : patterns ) signature += " "s + pattern;
+  signature += " "s + hierarchy_signature();
+  auto found = Resolved{};
+  auto cached = false;
+  if( not cache.empty() ) {
+    // Reuse the previous walk if patterns and hierarchy match and every object still resolves
+    auto in = std::ifstream{ cache };
+    auto line = string{};
+    cached = in and std::getline( in, line ) and line == signature;
+    while( cached and std::getline( in, line ) ) {
+      auto space = line.find_first_of( ' ' );
+      const Traceable* kind{ nullptr };
+      for( const auto& candidate : traceable ) {
+        if( space != npos and line.compare( 0, space, candidate.type ) == 0 ) kind = &candidate;
+      }
+      auto object = ( kind != nullptr ) ? sc_find_object( line.c_str() + space + 1 ) : nullptr;
+      cached = ( object != nullptr ) and kind->trace( object, true );
+      if( cached ) found.emplace_back( kind, object );
+    }
+  }
+  if( not cached ) {
+    found.clear();
+    for( auto object : sc_get_top_level_objects() ) {
+      find_signals( object, patterns, found );
+    }
+    drop_duplicates( found );
+    if( not cache.empty() ) {
+      auto out = std::ofstream{ cache };
+      out << signature << '\n';
+      for( const auto& [kind, object] : found ) out << kind->type << ' ' << object->name() << '\n';
+    }
+  }
+  for( const auto& [kind, object] : found ) {
+    kind->trace( object, false );
+  }
+  SC_REPORT_INFO_VERB( msg_type,
+                       ( "Found "s + std::to_string( found.size() ) + " signals to trace"s
+                       + ( cached ? " in "s + cache : ""s )
+                       ).c_str(),
+                       SC_MEDIUM
+                     );
+  return found.size();
+}
+
+//------------------------------------------------------------------------------
+// Phase timing
+//..............................................................................
+// Wall-clock and resource usage marks taken by the Hooks below. The hooks are
+// constructed by parse_command_line(), usually from the top's
+// before_end_of_elaboration(), so each mark falls after the design's own
+// callbacks for that phase. Resource usage covers all threads of the process
+// (including background trace writers); peak RSS is a high-water mark.
+namespace {
+  struct Usage_sample {
+    std::chrono::steady_clock::time_point wall{};
+    double user{ 0.0 };   // CPU seconds
+    double system{ 0.0 }; // CPU seconds
+    long   peak_rss_kib{ 0 };
+    long   minor_faults{ 0 };
+    long   major_faults{ 0 };
+    long   voluntary_switches{ 0 };
+    long   involuntary_switches{ 0 };
+  };
+
+  Usage_sample sample_usage()
+  {
+    Usage_sample sample;
+    sample.wall = std::chrono::steady_clock::now();
+#if __has_include(<sys/resource.h>)
+    rusage usage{};
+    if( getrusage( RUSAGE_SELF, &usage ) == 0 ) {
+      auto seconds = []( const timeval& t ) { return double( t.tv_sec ) + double( t.tv_usec ) * 1e-6; };
+      sample.user                 = seconds( usage.ru_utime );
+      sample.system               = seconds( usage.ru_stime );
+#ifdef __APPLE__
+      sample.peak_rss_kib         = usage.ru_maxrss / 1024; // bytes on macOS
+#else
+      sample.peak_rss_kib         = usage.ru_maxrss;
+#endif
+      sample.minor_faults         = usage.ru_minflt;
+      sample.major_faults         = usage.ru_majflt;
+      sample.voluntary_switches   = usage.ru_nvcsw;
+      sample.involuntary_switches = usage.ru_nivcsw;
+    }
+#endif
+    return sample;
+  }
+
+  const auto program_start = sample_usage(); // roughly when the executable was loaded
+
+  // --perf-db files hold one tab-separated line per run:
+  //   executable  options  wall_s  sim_s_per_wall_s  peak_rss_kib  reports
+  enum Perf_metric { perf_wall, perf_speed, perf_rss, perf_reports, perf_metrics };
+  using Perf_metrics = std::array<double, perf_metrics>;
+  constexpr std::array<const char*, perf_metrics> perf_metric_names{
+    "wall time", "sim time per wall second", "peak RSS", "reports"
+  };
+
+  std::string perf_metric_str( int metric, double value )
+  {
+    std::ostringstream os;
+    switch( metric ) {
+      case perf_wall:  os << Chronout::to_string( std::chrono::duration<double>( value ) ); break;
+      case perf_speed: os << Chronout::to_string( std::chrono::duration<double>( value ) ) << "/s"; break;
+      case perf_rss:   os << std::fixed << std::setprecision(1) << value / 1024.0 << "MiB"; break;
+      default:         os << std::fixed << std::setprecision(0) << value; break;
+    }
+    return os.str();
+  }
+
+  // Per metric median of the last `window` runs recorded under key; also returns how many
+  std::pair<size_t, Perf_metrics> read_perf_db( const std::string& filename, const std::string& key, size_t window = 5 )
+  {
+    auto runs = std::deque<Perf_metrics>{};
+    auto file = std::ifstream{ filename };
+    auto line = std::string{};
+    while( std::getline( file, line ) ) {
+      if( line.empty() or line[0] == '#' or line.compare( 0, key.size(), key ) != 0 or line[ key.size() ] != '\t' ) continue;
+      auto is = std::istringstream{ line.substr( key.size() + 1 ) };
+      auto run = Perf_metrics{};
+      for( auto& value : run ) is >> value;
+      if( not is.fail() ) runs.push_back( run );
+      if( runs.size() > window ) runs.pop_front();
+    }
+    auto median = Perf_metrics{};
+    for( int metric = perf_wall; metric < perf_metrics and not runs.empty(); ++metric ) {
+      auto values = std::vector<double>{};
+      for( const auto& run : runs ) values.push_back( run[metric] );
+      std::sort( values.begin(), values.end() );
+      median[metric] = values[ values.size() / 2 ];
+    }
+    return { runs.size(), median };
+  }
+}
+
+struct Debug::Phases
+{
+  using clock = std::chrono::steady_clock;
+  enum Phase { construction, elaboration, start_of_simulation, initialization, simulation, teardown, end };
+  static constexpr std::array<const char*, end> names{
+    "construction", "elaboration", "start_of_simulation", "initialization", "simulation", "teardown"
+  };
+
+  Phases() { samples[construction] = program_start; }
+
+  // Records the end of the phase before `next`
+  void mark( Phase next )
+  {
+    if( s_perf() != nullptr ) counters[next] = s_perf()->read();
+    samples[next] = sample_usage();
+    if( next == teardown ) {
+      sim_time = sc_time_stamp();
+      deltas   = sc_delta_count();
+    }
+  }
+  bool marked( int phase ) const { return samples[phase].wall != clock::time_point{}; }
+
+  // Table of phases that completed, followed by simulation speed
+  string to_string() const
+  {
+    std::ostringstream os;
+    os << "Phase timing\n"
+       << "------------\n"
+       << "  " << std::left << std::setw(20) << "phase" << std::right
+       << std::setw(10) << "wall" << std::setw(10) << "user" << std::setw(10) << "system"
+       << std::setw(10) << "peak RSS" << std::setw(10) << "minflt" << std::setw(8) << "majflt"
+       << std::setw(10) << "vcsw" << std::setw(10) << "ivcsw" << "\n";
+    for( int phase = construction; phase < end; ++phase ) {
+      if( not marked( phase ) ) continue;
+      auto next = phase + 1;
+      while( next < end and not marked( next ) ) ++next;
+      if( not marked( next ) ) break; // samples[end] is taken by exit_status()
+      const auto& from = samples[phase];
+      const auto& to   = samples[next];
+      std::ostringstream rss;
+      rss << std::fixed << std::setprecision(1) << to.peak_rss_kib / 1024.0 << "MiB";
+      os << "  " << std::left << std::setw(20) << names[phase] << std::right
+         << std::setw(10) << Chronout::to_string( to.wall - from.wall )
+         << std::setw(10) << Chronout::to_string( std::chrono::duration<double>( to.user - from.user ) )
+         << std::setw(10) << Chronout::to_string( std::chrono::duration<double>( to.system - from.system ) )
+         << std::setw(10) << rss.str()
+         << std::setw(10) << to.minor_faults - from.minor_faults
+         << std::setw(8)  << to.major_faults - from.major_faults
+         << std::setw(10) << to.voluntary_switches - from.voluntary_switches
+         << std::setw(10) << to.involuntary_switches - from.involuntary_switches
+         << "\n";
+    }
+    if( s_perf() != nullptr ) {
+      os << "  " << std::left << std::setw(20) << "phase" << std::right
+         << std::setw(16) << "cycles" << std::setw(16) << "instructions" << "  rates\n";
+      for( int phase = construction; phase < end; ++phase ) {
+        auto next = phase + 1;
+        while( next < end and not marked( next ) ) ++next;
+        auto used = counters[next] - counters[phase];
+        if( not marked( phase ) or not marked( next ) or not used.valid[Doulos::Perf_counters::cycles] ) continue;
+        os << "  " << std::left << std::setw(20) << names[phase] << std::right
+           << std::setw(16) << used.value[Doulos::Perf_counters::cycles]
+           << std::setw(16) << used.value[Doulos::Perf_counters::instructions]
+           << "  " << used.summary() << "\n";
+      }
+    }
+    if( marked( simulation ) and marked( teardown ) ) {
+      auto elapsed = samples[teardown].wall - samples[simulation].wall;
+      auto wall = std::chrono::duration<double>( elapsed ).count();
+      if( wall > 0 ) {
+        os << std::setprecision(4)
+           << "  Simulated " << sim_time.to_string() << " in " << Chronout::to_string( elapsed )
+           << ": " << sc_time( sim_time.to_seconds() / wall, SC_SEC ).to_string() << " per wall second, "
+           << static_cast<double>( deltas ) / wall << " delta cycles per second\n";
+      }
+    }
+    return os.str();
+  }
+
+  // Whole-run figures for --perf-db (once exit_status() has marked the end)
+  Perf_metrics metrics() const
+  {
+    auto result = Perf_metrics{};
+    result[perf_wall] = std::chrono::duration<double>( samples[end].wall - samples[construction].wall ).count();
+    if( marked( simulation ) and marked( teardown ) ) {
+      auto wall = std::chrono::duration<double>( samples[teardown].wall - samples[simulation].wall ).count();
+      if( wall > 0 ) result[perf_speed] = sim_time.to_seconds() / wall;
+    }
+    result[perf_rss] = static_cast<double>( samples[end].peak_rss_kib );
+    for( auto severity = SC_INFO; severity < max_severity; severity = static_cast<sc_severity>( severity + 1 ) ) {
+      result[perf_reports] += static_cast<double>( sc_report_handler::get_count( severity ) );
+    }
+    return result;
+  }
+
+  std::array<Usage_sample, end + 1> samples{}; // samples[end] is taken by exit_status()
+  std::array<Doulos::Perf_counters::Reading, end + 1> counters{}; // only with --perf
+  sc_time                           sim_time{ SC_ZERO_TIME };
+  sc_dt::uint64                     deltas{ 0 };
+};
+
+Debug::Phases& Debug::s_phases() {
+  static Phases phases{};
+  return phases;
+}
+
+//------------------------------------------------------------------------------
+// Internal module that gives Debug elaboration and simulation callbacks
+struct Debug::Hooks : sc_module
+{
+  explicit Hooks( const sc_module_name& instance ) : sc_module{ instance }
+  {
+    SC_HAS_PROCESS( Hooks );
+    SC_METHOD( initialization_method ); // runs once, during initialization
+  }
+  void before_end_of_elaboration() override
+  {
+    s_phases().mark( Phases::elaboration );
+  }
+  void end_of_elaboration() override
+  {
+    if( not s_trace_signals().empty() ) {
+      trace_signals( s_trace_signals(), parsed("trace-cache") ? get_text("trace-cache") : ""s );
+    }
+    s_phases().mark( Phases::start_of_simulation );
+  }
+  void start_of_simulation() override
+  {
+    s_phases().mark( Phases::initialization );
+  }
+  void initialization_method()
+  {
+    s_phases().mark( Phases::simulation );
+  }
+  void end_of_simulation() override
+  {
+    s_phases().mark( Phases::teardown );
+    s_check_windows(); // also cancels the --fail-fast check
+    Objection::report_statistics( SC_HIGH ); // see --verbose
+  }
+};
+
+void Debug::s_install_hooks() {
+  static Hooks* hooks{ nullptr }; // lives as long as the simulation
+  auto status = sc_get_status();
+  if( hooks == nullptr and ( status == SC_ELABORATION or status == SC_BEFORE_END_OF_ELABORATION ) ) {
+    hooks = new Hooks{ "debug_hooks" };
+  }
+}
+
+//------------------------------------------------------------------------------
+// Watchdog
+//..............................................................................
+// A host thread keeps the wall-clock budget and polls the kernel every
+// poll_period via async_request_update(), so the checks run in an update phase
+// without costing anything per delta cycle. The update compares progress with
+// the previous poll: a time step that has already run more than
+// max_deltas_per_step deltas, or a spent budget, is reported and sc_stop()'d.
+// The report names the last process that Info saw (entering, resuming, ...).
+// Only if the kernel stops answering polls after the budget is spent (e.g., a
+// process that never yields) does the host thread dump what it can and exit.
+#if SYSTEMC_VERSION >= 20171012
+struct Debug::Watchdog : sc_prim_channel
+{
+  using clock = std::chrono::steady_clock;
+  static constexpr auto poll_period = std::chrono::milliseconds{ 50 };
+
+  Watchdog( double max_wall, size_t max_deltas_per_step )
+  : sc_prim_channel{ "debug_watchdog" }
+  , m_max_wall{ max_wall }
+  , m_max_deltas{ max_deltas_per_step }
+  , m_start{ clock::now() }
+  , m_answered{ m_start.time_since_epoch().count() }
+  {
+    m_thread = std::thread{ [this]{ monitor(); } };
+  }
+
+  ~Watchdog() override { stop(); }
+
+  void stop() // joins the host thread
+  {
+    {
+      std::lock_guard<std::mutex> lock{ m_mutex };
+      m_done = true;
+    }
+    m_wake.notify_all();
+    if( m_thread.joinable() ) m_thread.join();
+  }
+
+  const string& tripped() const { return m_tripped; } // empty unless stopped
+
+private:
+  void start_of_simulation() override { m_running = true; }
+  void end_of_simulation() override   { m_running = false; }
+
+  static double seconds( clock::duration duration ) { return std::chrono::duration<double>( duration ).count(); }
+
+  // SystemC thread
+  void update() override
+  {
+    auto now = clock::now();
+    m_answered.store( now.time_since_epoch().count(), std::memory_order_relaxed );
+    if( not m_tripped.empty() ) return;
+    auto ticks = sc_time_stamp().value();
+    auto delta = sc_delta_count();
+    if( ticks != m_step_ticks or m_step_since == clock::time_point{} ) {
+      m_step_ticks = ticks;
+      m_step_delta = delta;
+      m_step_since = now;
+    }
+    auto deltas = delta - m_step_delta;
+    if( m_max_deltas != 0 and deltas > m_max_deltas ) {
+      trip( "more than "s + std::to_string( m_max_deltas ) + " delta cycles in one time step"s, now, deltas );
+    }
+    else if( m_expired.load( std::memory_order_relaxed ) ) {
+      std::ostringstream reason;
+      reason << "wall-clock limit of " << m_max_wall << " s exceeded";
+      trip( reason.str(), now, deltas );
+    }
+  }
+
+  // No process is current in the update phase, so name the last one that
+  // Info saw running (entering, resuming, executed...)
+  void trip( const string& reason, clock::time_point now, sc_dt::uint64 deltas )
+  {
+    auto process = s_last_process().empty() ? "(none reported by Info)"s : s_last_process();
+    m_tripped = reason + " (last process "s + process + ")"s;
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(3)
+       << "Watchdog: " << reason << " at " << Doulos::time_stamp()
+       << " (delta " << sc_delta_count() << ", " << deltas << " deltas in this step"
+       << ", time last advanced " << seconds( now - m_step_since ) << " s ago"
+       << ", last process " << process << ")"
+       << " after " << seconds( now - m_start ) << " s - stopping simulation";
+    SC_REPORT_INFO_VERB( msg_type, ( COLOR_ERROR + os.str() + COLOR_NONE ).c_str(), SC_NONE );
+    sc_stop();
+  }
+
+  // Host thread
+  void monitor()
+  {
+    auto grace = std::max( 1.0, m_max_wall / 10 ); // seconds to wait for an unresponsive kernel
+    std::unique_lock<std::mutex> lock{ m_mutex };
+    while( not m_wake.wait_for( lock, poll_period, [this]{ return m_done; } ) ) {
+      auto now = clock::now();
+      if( m_max_wall > 0 and seconds( now - m_start ) >= m_max_wall ) {
+        m_expired.store( true, std::memory_order_relaxed );
+        auto answered = clock::time_point{ clock::duration{ m_answered.load( std::memory_order_relaxed ) } };
+        if( m_running and seconds( now - answered ) > grace ) {
+          // Best effort: the kernel is stuck inside a process, so its state
+          // is not changing underneath us.
+          auto process = sc_get_current_process_handle();
+          std::fprintf( stderr
+                      , "Watchdog: wall-clock limit of %g s exceeded and the simulation has not responded for %.3f s"
+                        " (at %s, delta %llu, in process %s) - exiting\n"
+                      , m_max_wall, seconds( now - answered )
+                      , sc_time_stamp().to_string().c_str()
+                      , static_cast<unsigned long long>( sc_delta_count() )
+                      , process.valid() ? process.name() : "(none)"
+                      );
+          std::fflush( nullptr );
+          std::_Exit( EXIT_FAILURE );
+        }
+      }
+      async_request_update();
+    }
+  }
+
+  double                       m_max_wall;
+  size_t                       m_max_deltas;
+  clock::time_point            m_start;
+  std::atomic<clock::rep>      m_answered;          // when update() last ran
+  std::atomic<bool>            m_expired{ false };
+  std::atomic<bool>            m_running{ false };
+  sc_dt::uint64                m_step_ticks{ 0 };   // time step seen by the last update()
+  sc_dt::uint64                m_step_delta{ 0 };   // delta count when it was first seen
+  clock::time_point            m_step_since{};
+  string                       m_tripped{};
+  std::mutex                   m_mutex;
+  std::condition_variable      m_wake;
+  bool                         m_done{ false };
+  std::thread                  m_thread;
+};
+#else
+struct Debug::Watchdog {};
+#endif
+
+void Debug::set_watchdog( double max_wall, size_t max_deltas_per_step ) {
+#if SYSTEMC_VERSION >= 20171012
+  if( s_watchdog() != nullptr or ( sc_get_status() != SC_ELABORATION and sc_get_status() != SC_BEFORE_END_OF_ELABORATION ) ) {
+    REPORT_WARNING( "Ignoring watchdog request (only one, and only during elaboration)"s );
+    return;
+  }
+  s_watchdog() = new Watchdog{ max_wall, max_deltas_per_step }; // lives as long as the simulation
+  std::ostringstream os;
+  os << "Watchdog ENABLED";
+  if( max_wall > 0 )            os << ", wall-clock limit " << max_wall << " s";
+  if( max_deltas_per_step > 0 ) os << ", at most " << max_deltas_per_step << " deltas per time step";
+  SC_REPORT_INFO_VERB( msg_type, os.str().c_str(), SC_NONE );
+#else
+  (void)max_wall; (void)max_deltas_per_step;
+  REPORT_WARNING( "Watchdog requires SystemC 2.3.2 or later (async_request_update)"s );
+#endif
+}
+
+//..............................................................................
+void Debug::set_record_file( const string& filename ) {
+  if( s_recorder() != nullptr ) {
     SC_REPORT_INFO_VERB( msg_type,
-                         ( "Tracing to '"s + s_trace_name() + ".vcd'"s ).c_str(),
+                         ( "Recorded "s + std::to_string( s_recorder()->count() )
+                         + " transactions to '"s + s_recorder()->filename() + "'"s ).c_str(),
                          SC_NONE
                        );
+    delete s_recorder(); // flushes
+    s_recorder() = nullptr;
+  }
+  if( filename.length() != 0 ) {
+    s_recorder() = new Doulos::Tx_recorder( filename + ".txr"s );
+    if( not s_recorder()->is_open() ) { // already reported
+      delete s_recorder();
+      s_recorder() = nullptr;
+    }
+  }
+}
+
+//..............................................................................
+// Hardware counters are read at every phase mark and, for processes matching
+// the patterns, around Info::entering/leaving. They count the thread that
+// enabled them, which runs every process unless SystemC uses pthreads.
+struct Debug::Perf_process
+{
+  Doulos::Perf_counters::Reading total{};
+  Doulos::Perf_counters::Reading started{};
+  bool                           running{ false };
+  size_t                         intervals{ 0 };
+};
+
+void Debug::set_perf_counters( bool enable, const args_t& processes ) {
+  delete s_perf();
+  s_perf() = nullptr;
+  s_perf_patterns() = processes;
+  if( not enable ) return;
+  auto counters = new Doulos::Perf_counters{};
+  if( not counters->available() ) {
+    SC_REPORT_INFO_VERB( msg_type, ( "Performance counters unavailable - "s + counters->reason() ).c_str(), SC_NONE );
+    delete counters;
+    return;
+  }
+  s_perf() = counters;
+  SC_REPORT_INFO_VERB( msg_type, "Performance counters ENABLED", SC_NONE );
+}
+
+void Debug::set_perf_db( const string& filename, double gate_percent ) {
+  s_perf_db()   = filename;
+  s_perf_gate() = ( filename.empty() ) ? 0.0 : gate_percent;
+  if( filename.empty() ) return;
+  std::ostringstream os;
+  os << "Performance baseline ENABLED, using " << filename;
+  if( gate_percent > 0 ) os << ", failing on regressions over " << gate_percent << "%";
+  SC_REPORT_INFO_VERB( msg_type, os.str().c_str(), SC_NONE );
+}
+
+void Debug::s_perf_process( bool running ) {
+  if( s_perf() == nullptr or s_perf_patterns().empty() ) return;
+  auto process = sc_get_current_process_handle();
+  if( not process.valid() ) return;
+  string name{ process.name() };
+  if( std::none_of( s_perf_patterns().begin(), s_perf_patterns().end()
+                  , [&name]( const string& pattern ){ return hierarchy_match( pattern, name ); } ) ) return;
+  auto& counted = s_perf_processes()[name];
+  auto now = s_perf()->read();
+  if( running ) {
+    counted.started = now;
   }
+  else if( counted.running ) {
+    counted.total += now - counted.started;
+    ++counted.intervals;
+  }
+  counted.running = running;
+}
+
+//..............................................................................
+void Debug::set_trace_format( const string& format ) {
+  sc_assert( format == "vcd" or format == "avcd" or format == "bin" or format == "delta" );
+  s_trace_format() = format;
 }
 
 //..............................................................................
@@ -728,6 +1800,13 @@ void Debug::set_verbose( bool flag ) {
   }
 }
 
+//..............................................................................
+void Debug::set_fail_fast( bool flag ) {
+  s_fail_fast() = flag;
+  s_check_windows(); // (dis)arms the check at the next window deadline
+  SC_REPORT_INFO_VERB( msg_type, ( "Fail-fast "s + ( flag ? "ENABLED"s : "disabled"s ) ).c_str(), SC_NONE );
+}
+
 //..............................................................................
 void Debug::set_debugging( const mask_t& mask ) {
   s_debug() |= mask;
@@ -825,38 +1904,312 @@ const char* Debug::process() { //< return hierarchical process name
   return h.name();
 }
 
+//------------------------------------------------------------------------------
+// Expectations
+//..............................................................................
+// Expectations are compiled into one trie per severity keyed on the
+// '/'-separated levels of the msg_type. A `*` level matches exactly one level
+// and `**` matches any number of levels (including none). Literal levels are
+// preferred over `*`, which is preferred over `**`. An empty msg_type is the
+// anonymous expectation for that severity and catches anything unmatched.
+// Lookups are cached per msg_type, so repeated reports cost one hash lookup.
+struct Debug::Expectation_index
+{
+  static constexpr size_t none = ~size_t{};
+  struct Entry {
+    sc_severity severity;
+    string      pattern;
+    ssize_t     expected{ 0 };
+    ssize_t     observed{ 0 };
+    ssize_t     at_most { -1 }; //< negative means unbounded
+    bool        windowed{ false };
+    sc_time     from    {};
+    sc_time     until   {};
+    bool        checked { false }; //< window closed and checked
+    // Most observations allowed before the run can no longer pass
+    ssize_t limit() const {
+      if( at_most >= 0 ) return at_most;
+      return ( severity >= SC_ERROR ) ? expected : -1;
+    }
+  };
+  struct Node {
+    std::unordered_map<string,size_t> child{};
+    size_t star    { none };
+    size_t globstar{ none };
+    size_t entry   { none };
+  };
+
+  std::vector<Entry> entries{};
+  bool watched{ false }; //< set once a report handler calls see_expected
+  bool frozen { false }; //< set while exit_status reconciles
+  bool forwarding{ false }; //< set while report_handler calls the previous handler
+  bool pending{ false }; //< a window is still open and closes at deadline
+  sc_time deadline{};
+  sc_event* closes{ nullptr }; //< notified at deadline with --fail-fast (never deleted)
+
+  // Returns index into entries, creating an entry as needed
+  size_t add( sc_severity severity, const string& pattern )
+  {
+    cache[severity].clear();
+    cache_keys[severity].clear();
+    auto& nodes{ trie( severity ) };
+    auto node = size_t{ 0 };
+    if( not pattern.empty() ) {
+      for( const auto& level : split( pattern ) ) {
+        auto next = size_t{ none };
+        if      ( level == "*"  ) next = nodes[node].star;
+        else if ( level == "**" ) next = nodes[node].globstar;
+        else if ( auto it = nodes[node].child.find( string{ level } ); it != nodes[node].child.end() ) next = it->second;
+        if( next == none ) {
+          next = nodes.size();
+          if      ( level == "*"  ) nodes[node].star     = next;
+          else if ( level == "**" ) nodes[node].globstar = next;
+          else                      nodes[node].child[ string{ level } ] = next;
+          nodes.emplace_back(); //< invalidates references into nodes
+        }
+        node = next;
+      }
+    }
+    else {
+      node = anonymous_node;
+    }
+    if( nodes[node].entry == none ) {
+      nodes[node].entry = entries.size();
+      entries.push_back( Entry{ severity, pattern } );
+    }
+    return nodes[node].entry;
+  }
+
+  // Returns index into entries or none
+  size_t find( sc_severity severity, std::string_view msg_type )
+  {
+    auto& known{ cache[severity] };
+    if( auto it = known.find( msg_type ); it != known.end() ) return it->second;
+    const auto& nodes{ trie( severity ) };
+    auto result = match( nodes, 0, split( msg_type ), 0 );
+    if( result == none ) result = nodes[anonymous_node].entry;
+    // Key the cache with a stable copy of the msg_type
+    known.emplace( cache_keys[severity].emplace_back( msg_type ), result );
+    return result;
+  }
+
+private:
+  // Node 0 is the root and node 1 holds the anonymous (empty msg_type) entry
+  static constexpr size_t anonymous_node = 1;
+  std::array<std::vector<Node>,max_severity>                          tries{};
+  std::array<std::unordered_map<std::string_view,size_t>,max_severity> cache{};
+  std::array<std::deque<string>,max_severity>                         cache_keys{};
+
+  std::vector<Node>& trie( sc_severity severity )
+  {
+    auto& nodes{ tries[severity] };
+    if( nodes.empty() ) nodes.resize( 2 );
+    return nodes;
+  }
+
+  static std::vector<std::string_view> split( std::string_view text )
+  {
+    auto levels = std::vector<std::string_view>{};
+    for( auto pos = size_t{}; ; ) {
+      auto end = text.find( '/', pos );
+      levels.push_back( text.substr( pos, end - pos ) );
+      if( end == npos ) break;
+      pos = end + 1;
+    }
+    return levels;
+  }
+
+  static size_t match( const std::vector<Node>& nodes, size_t node
+                     , const std::vector<std::string_view>& levels, size_t i )
+  {
+    auto result = size_t{ none };
+    const auto& here{ nodes[node] };
+    if( i == levels.size() and here.entry != none ) return here.entry;
+    if( i < levels.size() ) {
+      if( auto it = here.child.find( string{ levels[i] } ); it != here.child.end() ) {
+        if( ( result = match( nodes, it->second, levels, i + 1 ) ) != none ) return result;
+      }
+      if( here.star != none ) {
+        if( ( result = match( nodes, here.star, levels, i + 1 ) ) != none ) return result;
+      }
+    }
+    if( here.globstar != none ) {
+      for( auto j = i; j <= levels.size(); ++j ) {
+        if( ( result = match( nodes, here.globstar, levels, j ) ) != none ) return result;
+      }
+    }
+    return none;
+  }
+};
+
 //..............................................................................
 void Debug::add_expected( sc_severity severity, const string& msg_type_, ssize_t n )
 {
   sc_assert( severity > SC_INFO and severity < max_severity );
-  auto key = std::pair<sc_severity, string>{severity,msg_type_};
-  if ( s_expected_map().count(key) == 0 ) {
-    s_expected_map()[key] = n;
+  auto& index{ s_expectations() };
+  index.entries[ index.add( severity, msg_type_ ) ].expected += n;
+}
+
+//..............................................................................
+// Windowed expectations only count reports in [from,until). Missed windows are
+// noticed by the first report after until, at until with --fail-fast, or at
+// the end of simulation.
+void Debug::add_expected( sc_severity severity, const string& msg_type_, ssize_t n, ssize_t at_most
+                        , const sc_time& from, const sc_time& until )
+{
+  add_expected( severity, msg_type_, n );
+  auto& index{ s_expectations() };
+  auto i = index.add( severity, msg_type_ );
+  auto& entry{ index.entries[i] };
+  entry.at_most  = at_most;
+  entry.windowed = ( from != SC_ZERO_TIME or until != sc_max_time() );
+  entry.from     = from;
+  entry.until    = until;
+  entry.checked  = false;
+  s_check_windows();
+}
+
+//..............................................................................
+// Checks windowed expectations that have closed since the last call, and
+// notes when the next one closes. Only with --fail-fast does a method wake at
+// that time, since its timed notification keeps sc_start() running until then.
+void Debug::s_check_windows()
+{
+  auto& index{ s_expectations() };
+  auto now = sc_time_stamp();
+  index.pending = false;
+  for( auto& entry : index.entries ) {
+    if( not entry.windowed or entry.checked or entry.until == sc_max_time() ) continue;
+    if( entry.until > now ) {
+      if( not index.pending or entry.until < index.deadline ) index.deadline = entry.until;
+      index.pending = true;
+      continue;
+    }
+    entry.checked = true;
+    if( entry.observed < entry.expected ) {
+      s_impossible( "Missed "s + std::to_string( entry.expected - entry.observed )
+                  + " expected "s + severity_str( entry.severity ) + " reports"s
+                  + ( entry.pattern.empty() ? ""s : " from "s + entry.pattern )
+                  + " before "s + entry.until.to_string()
+                  );
+    }
   }
-  else {
-    s_expected_map()[key] += n;
+  auto ending = sc_end_of_simulation_invoked() or sc_get_status() == SC_END_OF_SIMULATION;
+  if( index.closes != nullptr ) index.closes->cancel();
+  if( ending or not index.pending or not s_fail_fast() ) return;
+  if( index.closes == nullptr ) {
+    index.closes = new sc_event{ "debug_expectation_window" };
+    sc_spawn_options options;
+    options.spawn_method();
+    options.dont_initialize();
+    options.set_sensitivity( index.closes );
+    sc_spawn( []{ s_check_windows(); }, sc_gen_unique_name( "expectation_window" ), &options );
   }
+  index.closes->notify( index.deadline - now );
 }
 
 //..............................................................................
 void Debug::see_expected( sc_severity severity, const std::string& msg_type_ )
 {
-  auto key = std::pair<sc_severity, string>{severity,msg_type_};
-  if ( s_expected_map().count(key) == 0 ) {
-    // Allow for anonymous expectations
-    key.second = "";
-    if ( s_expected_map().count(key) == 0 ) return;
+  s_observe( severity, msg_type_.c_str() );
+}
+
+//..............................................................................
+// Avoids constructing a std::string per report
+void Debug::s_observe( sc_severity severity, const char* msg_type_ )
+{
+  auto& index{ s_expectations() };
+  if( index.frozen or index.forwarding ) return;
+  index.watched = true;
+  if( index.pending and sc_time_stamp() >= index.deadline ) s_check_windows();
+  auto i = index.entries.empty() ? Expectation_index::none : index.find( severity, msg_type_ );
+  if( i != Expectation_index::none ) {
+    auto& entry{ index.entries[i] };
+    if( not entry.windowed
+        or ( entry.from <= sc_time_stamp() and sc_time_stamp() < entry.until ) ) {
+      ++entry.observed;
+      if( entry.limit() >= 0 and entry.observed > entry.limit() ) {
+        s_impossible( "Exceeded "s + std::to_string( entry.limit() )
+                    + " expected "s + severity_str( severity ) + " reports from "s + msg_type_
+                    );
+      }
+      return;
+    }
+  }
+  if( severity >= SC_ERROR ) {
+    s_impossible( "Unexpected "s + severity_str( severity ) + " report from "s + msg_type_ );
+  }
+}
+
+//..............................................................................
+// Called when an expectation can no longer be met. Only acts if fail-fast is
+// enabled. Note this may be called from within the report handler, so it must
+// not issue warnings or errors itself.
+void Debug::s_impossible( const string& reason )
+{
+  static bool stopped{ false };
+  if( not s_fail_fast() or stopped ) return;
+  stopped = true;
+  SC_REPORT_INFO_VERB( msg_type
+                     , ( COLOR_ERROR + "Fail-fast: "s + reason
+                       + " at "s + Doulos::time_stamp()
+                       + " - stopping simulation"s + COLOR_NONE
+                       ).c_str()
+                     , SC_NONE
+                     );
+  if( sc_is_running() ) {
+    sc_stop();
+  }
+  else {
+    s_stop() = true;
+  }
+}
+
+//..............................................................................
+// Installed by parse_command_line() unless --no-report-handler is specified.
+void Debug::set_report_handler( bool install )
+{
+  auto& previous{ s_previous_handler() };
+  if( install and previous == nullptr ) {
+    previous = sc_report_handler::set_handler( &Debug::report_handler );
+    s_expectations().watched = true;
+  }
+  else if( not install and previous != nullptr ) {
+    if( sc_report_handler::get_handler() == &Debug::report_handler ) {
+      sc_report_handler::set_handler( previous );
+    }
+    previous = nullptr;
+    s_expectations().watched = false;
+  }
+}
+
+//..............................................................................
+void Debug::report_handler( const sc_report& report, const sc_actions& actions )
+{
+  if( report.get_severity() != SC_INFO ) {
+    s_observe( report.get_severity(), report.get_msg_type() );
   }
-  ++s_observed_map()[key];
+  auto previous = s_previous_handler();
+  if( previous == nullptr ) previous = &sc_report_handler::default_handler;
+  // Ignore observations from handlers further down the chain that also call
+  // see_expected(), so each report is counted exactly once. The previous
+  // handler may throw (SC_THROW), hence the guard.
+  struct Forwarding {
+    bool& flag;
+    bool  saved;
+    explicit Forwarding( bool& f ) : flag{f}, saved{f} { flag = true; }
+    ~Forwarding() { flag = saved; }
+  } guard{ s_expectations().forwarding };
+  previous( report, actions );
 }
 
 //..............................................................................
 ssize_t Debug::get_expected( sc_severity severity )
 {
   auto count = ssize_t{};
-  for( auto [key,n] : s_expected_map() ) {
-    if ( severity == max_severity or key.first == severity ) {
-      count += n;
+  for( const auto& entry : s_expectations().entries ) {
+    if ( severity == max_severity or entry.severity == severity ) {
+      count += entry.expected;
     }
   }
   return count;
@@ -866,9 +2219,9 @@ ssize_t Debug::get_expected( sc_severity severity )
 ssize_t Debug::get_observed( sc_severity severity )
 {
   auto count = ssize_t{};
-  for( auto [key,n] : s_observed_map() ) {
-    if ( severity == max_severity or key.first == severity ) {
-      count += n;
+  for( const auto& entry : s_expectations().entries ) {
+    if ( severity == max_severity or entry.severity == severity ) {
+      count += entry.observed;
     }
   }
   return count;
@@ -1023,16 +2376,98 @@ string Debug::verbosity_str()
 
 int Debug::exit_status( const string& project )
 {
+  if( tracing() ) {
+    close_trace_file(); // flush before results so files are complete even if the caller leaks modules
+  }
+  if( recording() ) {
+    close_record_file();
+  }
+  auto watchdog = ""s;
+#if SYSTEMC_VERSION >= 20171012
+  if( s_watchdog() != nullptr ) {
+    s_watchdog()->stop();
+    watchdog = s_watchdog()->tripped();
+  }
+#endif
+  auto perf_processes = []{
+    if( s_perf_processes().empty() ) return ""s;
+    std::ostringstream os;
+    os << "  " << std::left << std::setw(32) << "process" << std::right
+       << std::setw(10) << "intervals" << std::setw(16) << "cycles" << std::setw(16) << "instructions" << "  rates\n";
+    for( const auto& [name, counted] : s_perf_processes() ) {
+      os << "  " << std::left << std::setw(32) << name << std::right
+         << std::setw(10) << counted.intervals
+         << std::setw(16) << counted.total.value[Doulos::Perf_counters::cycles]
+         << std::setw(16) << counted.total.value[Doulos::Perf_counters::instructions]
+         << "  " << counted.total.summary() << "\n";
+    }
+    return os.str();
+  };
+  // Compares this run with earlier ones of the same executable & options,
+  // then appends it unless it failed or regressed
+  auto perf_baseline = []( bool passed, bool& regressed ) {
+    auto executable = string{ sc_argv()[0] };
+    auto pos = executable.find_last_of("/\\:");
+    if( pos != npos ) executable.erase( 0, pos + 1 );
+    auto options = ""s;
+    for( const auto& arg : s_config() ) {
+      if( arg.substr(0,9) == "--perf-db" or arg.substr(0,11) == "--perf-gate" ) continue;
+      options += ( options.empty() ? ""s : " "s ) + arg;
+    }
+    auto key = executable + "\t"s + options;
+    auto now = s_phases().metrics();
+    auto [runs, baseline] = read_perf_db( s_perf_db(), key );
+    std::ostringstream os;
+    if( runs == 0 ) {
+      os << "  Performance baseline: first run of this configuration in " << s_perf_db() << "\n";
+    }
+    else {
+      os << "  Performance versus median of " << runs << " earlier run(s) in " << s_perf_db() << "\n";
+      for( int metric = perf_wall; metric < perf_metrics; ++metric ) {
+        auto worse = 0.0; // percent
+        if( metric == perf_speed ) { if( now[metric] > 0 ) worse = 100.0 * ( baseline[metric] / now[metric] - 1.0 ); }
+        else                       { if( baseline[metric] > 0 ) worse = 100.0 * ( now[metric] / baseline[metric] - 1.0 ); }
+        auto failed = s_perf_gate() > 0 and worse > s_perf_gate();
+        regressed = regressed or failed;
+        os << ( failed ? COLOR_ERROR : ""s )
+           << "    " << std::left << std::setw(26) << perf_metric_names[metric] << std::right
+           << std::setw(12) << perf_metric_str( metric, now[metric] ) << " vs "
+           << std::setw(12) << perf_metric_str( metric, baseline[metric] )
+           << std::fixed << std::setprecision(1) << std::showpos << "  (" << worse << "% worse)" << std::noshowpos
+           << ( failed ? " REGRESSED"s + COLOR_NONE : ""s ) << "\n";
+      }
+    }
+    if( passed and not regressed ) {
+      auto exists = std::ifstream{ s_perf_db() }.good();
+      auto file = std::ofstream{ s_perf_db(), std::ios::app };
+      if( not exists ) file << "# executable\toptions\twall_s\tsim_s_per_wall_s\tpeak_rss_kib\treports\n";
+      file << key;
+      for( auto value : now ) file << '\t' << value;
+      file << '\n';
+      if( not file ) os << COLOR_WARN << "  Unable to record performance in " << s_perf_db() << COLOR_NONE << "\n";
+    }
+    else {
+      os << "  Performance not recorded (run failed)\n";
+    }
+    return os.str();
+  };
+  if( not s_phases().marked( Phases::teardown ) ) {
+    s_phases().mark( Phases::teardown ); // end_of_simulation() was not invoked
+  }
+  s_phases().mark( Phases::end );
   auto message  = "\n"s
       + Debug::get_opts("")
       + "\n"s
+      + s_phases().to_string()
+      + perf_processes()
+      + "\n"s
       + "Simulation results\n"s
       + "------------------\n"s
       ;
 
+  s_expectations().frozen = true; //< our own reports are not observations
   auto expected_total = get_expected( max_severity );
   auto surprise_total = ssize_t{0};
-  auto observed_total = get_observed( max_severity );
   auto severity_color = std::array<string,max_severity>{ COLOR_INFO, COLOR_WARN, COLOR_ERROR, COLOR_FATAL };
   auto severity_count = std::array<ssize_t,max_severity>{};
   for( auto severity = SC_INFO; severity < max_severity; severity = static_cast<sc_severity>(severity + 1) ) {
@@ -1041,7 +2476,7 @@ int Debug::exit_status( const string& project )
 
     // Deal with expected messages if any
     if ( expected_total > 0 ) {
-      if ( observed_total == 0 ) {
+      if ( not s_expectations().watched ) { // no report handler, so use totals
         auto expected_count = get_expected(severity);
         if ( the_count < expected_count ) {
           surprise_total += expected_count - the_count;
@@ -1059,28 +2494,30 @@ int Debug::exit_status( const string& project )
         }
       } 
       else /* detailed observations */ {
-        for( auto [expected_key,expected_count] : s_expected_map() ) {
-          if ( expected_key.first != severity ) continue;
-          for( auto [observed_key,observed_count] : s_observed_map() ) {
-            if( observed_key == expected_key ) {
-              if( observed_count >= expected_count ) {
-                // Expectations met
-                the_count -= expected_count;
-              }
-              else {
-                surprise_total += expected_count - observed_count;
-                auto where = expected_key.second.empty() ? ""s : (" from "s + expected_key.second);
-                auto missed_message = "Missed "s;
-                missed_message += std::to_string( expected_count - observed_count );
-                missed_message += " expected ";
-                missed_message += severity_str(severity);
-                missed_message += " reports.";
-                missed_message += where;
-                REPORT_ERROR( missed_message );
-                ++severity_count[SC_ERROR];
-                the_count -= observed_count;
-              }
-            }
+        for( const auto& entry : s_expectations().entries ) {
+          if ( entry.severity != severity ) continue;
+          if( entry.at_most >= 0 and entry.observed > entry.at_most ) {
+            auto where = entry.pattern.empty() ? ""s : (" from "s + entry.pattern);
+            REPORT_ERROR( "Exceeded "s + std::to_string( entry.at_most ) + " allowed "s
+                        + severity_str(severity) + " reports."s + where );
+            ++severity_count[SC_ERROR];
+          }
+          if( entry.observed >= entry.expected ) {
+            // Expectations met
+            the_count -= entry.expected;
+          }
+          else {
+            surprise_total += entry.expected - entry.observed;
+            auto where = entry.pattern.empty() ? ""s : (" from "s + entry.pattern);
+            auto missed_message = "Missed "s;
+            missed_message += std::to_string( entry.expected - entry.observed );
+            missed_message += " expected ";
+            missed_message += severity_str(severity);
+            missed_message += " reports.";
+            missed_message += where;
+            REPORT_ERROR( missed_message );
+            ++severity_count[SC_ERROR];
+            the_count -= entry.observed;
           }
         }//end for
       }
@@ -1105,7 +2542,16 @@ int Debug::exit_status( const string& project )
     message += "  Surprised by "s + std::to_string( surprise_total ) + " missed expectations\n"s;
   }
 
-  auto ok =  (severity_count[SC_ERROR] + severity_count[SC_FATAL]) == 0 ;
+  if ( not watchdog.empty() ) {
+    message += COLOR_ERROR + "  Watchdog stopped the simulation: "s + watchdog + "\n"s + COLOR_NONE;
+  }
+
+  auto ok =  (severity_count[SC_ERROR] + severity_count[SC_FATAL]) == 0 and watchdog.empty();
+  if( not s_perf_db().empty() ) {
+    auto regressed = false;
+    message += perf_baseline( ok, regressed );
+    ok = ok and not regressed;
+  }
   if( ok ) {
     message += COLOR_GREEN + COLOR_BOLD
       + "\nNo major problems - Simulation PASSED."s
@@ -1146,11 +2592,81 @@ sc_trace_file*& Debug::s_trace_file() {
   return trace_file;
 }
 
+Debug::Watchdog*& Debug::s_watchdog() {
+  static Watchdog* watchdog{nullptr};
+  return watchdog;
+}
+
+string& Debug::s_last_process() {
+  static string name{};
+  return name;
+}
+
+Doulos::Perf_counters*& Debug::s_perf() {
+  static Doulos::Perf_counters* counters{nullptr};
+  return counters;
+}
+
+string& Debug::s_perf_db() {
+  static string filename{};
+  return filename;
+}
+
+double& Debug::s_perf_gate() {
+  static double percent{ 0.0 };
+  return percent;
+}
+
+std::map<string,Debug::Perf_process>& Debug::s_perf_processes() {
+  static std::map<string,Perf_process> processes{};
+  return processes;
+}
+
+Debug::args_t& Debug::s_perf_patterns() {
+  static args_t patterns{};
+  return patterns;
+}
+
+Doulos::Tx_recorder*& Debug::s_recorder() {
+  static Doulos::Tx_recorder* recorder{nullptr};
+  return recorder;
+}
+
 string& Debug::s_trace_name() {
   static string trace_name{};
   return trace_name;
 }
 
+string& Debug::s_trace_format() {
+  static string trace_format{"vcd"};
+  return trace_format;
+}
+
+string& Debug::s_trace_pending() {
+  static string trace_pending{};
+  return trace_pending;
+}
+
+Debug::args_t& Debug::s_trace_include() {
+  static args_t trace_include{};
+  return trace_include;
+}
+
+Debug::args_t& Debug::s_trace_exclude() {
+  static args_t trace_exclude{};
+  return trace_exclude;
+}
+
+Debug::args_t& Debug::s_trace_signals() {
+  static args_t trace_signals{};
+  return trace_signals;
+}
+
+std::map<string,Debug::trace_registration_t>& Debug::s_trace_registrations() {
+  static std::map<string,trace_registration_t> trace_registrations{};
+  return trace_registrations;
+}
+
 Debug::args_t& Debug::s_config() {
   static args_t config;
   return config;
@@ -1181,6 +2697,11 @@ bool& Debug::s_werror() {
   return werror;
 }
 
+bool& Debug::s_fail_fast() {
+  static bool fail_fast{false};
+  return fail_fast;
+}
+
 // Maps
 std::map<string,size_t>& Debug::s_count_map() {
   static std::map<string,size_t>  the_map;
@@ -1206,13 +2727,14 @@ std::map<string,size_t>& Debug::s_parsed_map() {
   static std::map<string,size_t> the_map;
   return the_map;
 }
-std::map<Debug::severity_n_type,ssize_t>& Debug::s_expected_map() {
-  static std::map<severity_n_type,ssize_t> the_map;
-  return the_map;
+sc_report_handler_proc& Debug::s_previous_handler() {
+  static sc_report_handler_proc previous{nullptr};
+  return previous;
 }
-std::map<Debug::severity_n_type,ssize_t>& Debug::s_observed_map() {
-  static std::map<severity_n_type,ssize_t> the_map;
-  return the_map;
+
+Debug::Expectation_index& Debug::s_expectations() {
+  static Expectation_index the_index;
+  return the_index;
 }
 
 // Options
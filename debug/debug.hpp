@@ -7,6 +7,7 @@
 #include <vector>
 #include <cstdio>
 #include <map>
+#include <functional>
 #include <cmath>
 #include "report.hpp"
 using namespace std::literals;
@@ -24,6 +25,9 @@ namespace Doulos {
 
 std::string version();
 
+class Tx_recorder; // see tx_recorder.hpp
+class Perf_counters; // see perf_counters.hpp
+
 struct Info {
   using cstr_t = const char*;
   using sc_object = ::sc_core::sc_object;
@@ -63,12 +67,17 @@ struct Debug {
   static constexpr cstr_t msg_type = "/Doulos/Debug";
   static constexpr sc_severity max_severity = sc_core::SC_MAX_SEVERITY;
   static sc_trace_file* trace_file()                          { return s_trace_file(); }
-  static           bool tracing()                             { return s_trace_file() != nullptr; }
+  static           bool tracing()                             { return s_trace_file() != nullptr or not s_trace_pending().empty(); }
+  static         string trace_format()                        { return s_trace_format(); }
+  static Doulos::Tx_recorder* recorder()                      { return s_recorder(); } // nullptr unless recording
+  static           bool recording()                           { return s_recorder() != nullptr; }
+  static Doulos::Perf_counters* perf_counters()               { return s_perf(); } // nullptr unless counting
   static           bool debugging( const mask_t& mask = ~0u ) { return (s_debug() & mask) != 0u; }
   static           bool injecting( const mask_t& mask = ~0u ) { return (s_inject() & mask) != 0u; }
   static           bool stopping()                            { return s_stop(); }
   static           bool verbose()                             { return s_verbose(); }
   static           bool quiet()                               { return s_quiet(); }
+  static           bool fail_fast()                           { return s_fail_fast(); }
   static        args_t& config()                              { return s_config(); }
   static           bool stop_requested()                      { return s_stop(); }
   static         size_t get_count(const string& name)         { return s_count(name, false); }
@@ -77,20 +86,38 @@ struct Debug {
   static         string get_text(const string& name)          { return s_text(name, false); }
   static         double get_value(const string& name)         { return s_value(name, false); }
   static           void close_trace_file()                    { set_trace_file(""); }
+  static           void close_record_file()                   { set_record_file(""); }
 
   static           void add_expected( sc_severity severity, const string& msg_type_ = "", ssize_t n = 1 );
+  static           void add_expected( sc_severity severity, const string& msg_type_, ssize_t n, ssize_t at_most
+                                    , const sc_time& from = sc_core::SC_ZERO_TIME
+                                    , const sc_time& until = sc_core::sc_max_time() ); // window is [from,until)
   static           void see_expected( sc_severity severity, const string& msg_type_ = "" );
   static        ssize_t get_expected( sc_severity severity = max_severity );
   static        ssize_t get_observed( sc_severity severity = max_severity );
+  static           void set_report_handler( bool install = true ); // chains to the previous handler
+  static           void report_handler( const sc_core::sc_report& report, const sc_core::sc_actions& actions );
 
   static void   read_configuration( args_t& args, string filename = "" );
   static void   parse_command_line();
   static void   breakpoint( const string& tag = "" );
   static void   resume();
   static void   stop_if_requested();
-  static void   set_trace_file( const string& filename );
+  static void   set_trace_file( const string& filename ); // uses trace_format()
+  static void   set_trace_format( const string& format );  // "vcd", "avcd", "bin" or "delta" (applies to the next file)
+  static void   set_record_file( const string& filename ); // transaction recording; appends .txr
+  static void   set_perf_counters( bool enable = true, const args_t& processes = {} ); // hardware counters per phase & selected processes
+  static void   set_trace_window( const string& filename, const sc_time& from
+                                , const sc_time& until = sc_core::sc_max_time() ); // window is [from,until)
+  template<typename T>
+  static void   trace( const T& object, const string& name, const sc_object* scope = nullptr ); // filtered sc_trace
+  static bool   trace_selected( const string& path ); // applies --trace-include/--trace-exclude
+  static size_t trace_signals( const args_t& patterns = { "**" }, const string& cache = "" ); // after elaboration
   static void   set_quiet( bool flag = true );
   static void   set_verbose( bool flag = true );
+  static void   set_fail_fast( bool flag = true ); // stop as soon as expectations cannot be met
+  static void   set_watchdog( double max_wall, size_t max_deltas_per_step = 0 ); // seconds; zero disables either
+  static void   set_perf_db( const string& filename, double gate_percent = 0.0 ); // compare with & append to baseline in exit_status()
   static void   set_debugging( const mask_t& mask = 1 ); // 0 => no-change
   static void   clr_debugging( const mask_t& mask = 0 ); // 0 => all cleared
   static void   set_injecting( const mask_t& mask = 1 );
@@ -131,15 +158,34 @@ private:
   static mask_t&  s_inject();
   static mask_t&  s_debug();
   static string&  s_trace_name();
+  static string&  s_trace_format(); // "vcd", "avcd", "bin" or "delta"
+  static string&  s_trace_pending(); // file to open when the trace window starts
+  static args_t&  s_trace_include();
+  static args_t&  s_trace_exclude();
+  static args_t&  s_trace_signals(); // --trace-signals patterns
+  struct Hooks; // see debug.cpp
+  struct Trace_window; // see debug.cpp
+  static void     s_install_hooks();
+  struct Phases; // see debug.cpp
+  static Phases&  s_phases();
+  using trace_registration_t = std::function<void( sc_trace_file* )>;
+  static std::map<string,trace_registration_t>& s_trace_registrations(); // by path; replayed for each new file
   static args_t&  s_config();
   static bool&    s_stop();
   static bool&    s_quiet();
   static bool&    s_verbose();
   static bool&    s_warn();
   static bool&    s_werror();
-  using severity_n_type = std::pair<sc_severity,string>;
-  static std::map<severity_n_type,ssize_t>& s_expected_map();
-  static std::map<severity_n_type,ssize_t>& s_observed_map();
+  static bool&    s_fail_fast();
+  struct Expectation_index; // see debug.cpp
+  static Expectation_index& s_expectations();
+  static void     s_observe( sc_severity severity, const char* msg_type_ );
+  static void     s_impossible( const string& reason );
+  static void     s_check_windows();
+  struct Watchdog; // see debug.cpp
+  static Watchdog*& s_watchdog();
+  static string&  s_last_process(); // last process seen by Info (for the watchdog)
+  static sc_core::sc_report_handler_proc& s_previous_handler();
   static std::map<string,size_t>&  s_count_map();
   static std::map<string,sc_time>& s_time_map();
   static std::map<string,bool>&    s_flag_map();
@@ -154,5 +200,36 @@ private:
   static void     s_parsed ( const string& name );
   static string   get_opts ( const string& prefix = "" );
   static sc_trace_file*& s_trace_file();
+  static Doulos::Tx_recorder*& s_recorder();
+  static Doulos::Perf_counters*& s_perf();
+  static string& s_perf_db();   // --perf-db file or empty
+  static double& s_perf_gate(); // --perf-gate percentage or zero
+  struct Perf_process; // see debug.cpp
+  static std::map<string,Perf_process>& s_perf_processes(); // by process name
+  static args_t&  s_perf_patterns(); // processes to count between Info::entering/leaving
+  static void     s_perf_process( bool running ); // called by Info
+  friend struct Doulos::Info;
 
 };
+
+//..............................................................................
+// Registers object for tracing under scope's hierarchical name if selected by
+// --trace-include/--trace-exclude. Registrations are remembered so that a file
+// opened later (e.g., by --trace-from) receives them too. Repeats are ignored.
+template<typename T>
+void Debug::trace( const T& object, const string& name, const sc_object* scope )
+{
+  if( not tracing() ) return;
+  auto path = ( scope != nullptr ) ? string{ scope->name() } + "."s + name : name;
+  if( not trace_selected( path ) ) {
+    SC_REPORT_INFO_VERB( msg_type, ( "Not tracing "s + path ).c_str(), sc_core::SC_DEBUG );
+    return;
+  }
+  auto [registration, added] = s_trace_registrations().emplace( path, [&object,path]( sc_trace_file* file ) {
+    using sc_core::sc_trace; // allow user-defined sc_trace via ADL
+    sc_trace( file, object, path );
+  } );
+  if( added and s_trace_file() != nullptr ) {
+    registration->second( s_trace_file() );
+  }
+}
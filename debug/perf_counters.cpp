@@ -0,0 +1,151 @@
+#include "perf_counters.hpp"
+#include <cerrno>
+#include <cstring>
+#include <iomanip>
+#include <sstream>
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+using namespace std::literals;
+
+namespace Doulos {
+
+#if defined(__linux__)
+namespace {
+  constexpr std::array<std::uint64_t, Perf_counters::events> configs{
+    PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES
+  };
+
+  int open_event( std::uint64_t config, int group )
+  {
+    perf_event_attr attr{};
+    attr.size           = sizeof( attr );
+    attr.type           = PERF_TYPE_HARDWARE;
+    attr.config         = config;
+    attr.disabled       = ( group == -1 ) ? 1 : 0; // the leader starts the group
+    attr.exclude_kernel = 1;
+    attr.exclude_hv     = 1;
+    attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    return static_cast<int>( syscall( SYS_perf_event_open, &attr, 0, -1, group, 0 ) ); // this thread, any CPU
+  }
+}
+#endif
+
+//------------------------------------------------------------------------------
+Perf_counters::Perf_counters()
+{
+#if defined(__linux__)
+  for( int event = cycles; event < events; ++event ) {
+    auto fd = open_event( configs[event], m_leader );
+    if( fd < 0 ) {
+      if( m_leader < 0 ) {
+        m_reason = "perf_event_open("s + names[event] + "): "s + std::strerror( errno );
+        if( errno == EACCES or errno == EPERM ) m_reason += " (see /proc/sys/kernel/perf_event_paranoid)"s;
+        if( errno == ENOENT or errno == ENODEV ) m_reason += " (no hardware PMU, e.g. in a virtual machine)"s;
+        return; // without cycles there is nothing to lead the group
+      }
+      continue; // e.g., the CPU has no such event
+    }
+    if( m_leader < 0 ) m_leader = fd;
+    m_fd[event]   = fd;
+    m_slot[event] = m_opened++;
+  }
+  ioctl( m_leader, PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+  ioctl( m_leader, PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+#else
+  m_reason = "hardware counters require Linux perf_event_open"s;
+#endif
+}
+
+Perf_counters::~Perf_counters()
+{
+#if defined(__linux__)
+  for( auto fd : m_fd ) {
+    if( fd >= 0 ) close( fd );
+  }
+#endif
+}
+
+//..............................................................................
+Perf_counters::Reading Perf_counters::read() const
+{
+  Reading result;
+#if defined(__linux__)
+  if( not available() ) return result;
+  struct {
+    std::uint64_t nr;
+    std::uint64_t time_enabled;
+    std::uint64_t time_running;
+    std::uint64_t values[events];
+  } data{};
+  if( ::read( m_leader, &data, sizeof( data ) ) <= 0 or data.time_running == 0 ) return result;
+  auto scale = static_cast<double>( data.time_enabled ) / static_cast<double>( data.time_running );
+  for( int event = cycles; event < events; ++event ) {
+    if( m_slot[event] < 0 or std::uint64_t( m_slot[event] ) >= data.nr ) continue;
+    auto value = data.values[ m_slot[event] ];
+    result.value[event] = ( data.time_running == data.time_enabled ) ? value : static_cast<std::uint64_t>( value * scale );
+    result.valid[event] = true;
+  }
+#endif
+  return result;
+}
+
+//------------------------------------------------------------------------------
+Perf_counters::Reading& Perf_counters::Reading::operator+=( const Reading& rhs )
+{
+  for( int event = cycles; event < events; ++event ) {
+    value[event] += rhs.value[event];
+    valid[event] = valid[event] or rhs.valid[event];
+  }
+  return *this;
+}
+
+Perf_counters::Reading operator-( Perf_counters::Reading lhs, const Perf_counters::Reading& rhs )
+{
+  for( int event = Perf_counters::cycles; event < Perf_counters::events; ++event ) {
+    lhs.valid[event] = lhs.valid[event] and rhs.valid[event];
+    lhs.value[event] = lhs.valid[event] ? lhs.value[event] - rhs.value[event] : 0;
+  }
+  return lhs;
+}
+
+double Perf_counters::Reading::ipc() const
+{
+  if( not valid[cycles] or not valid[instructions] or value[cycles] == 0 ) return 0.0;
+  return static_cast<double>( value[instructions] ) / static_cast<double>( value[cycles] );
+}
+
+double Perf_counters::Reading::per_kilo_instruction( Event event ) const
+{
+  if( not valid[event] or not valid[instructions] or value[instructions] == 0 ) return 0.0;
+  return 1000.0 * static_cast<double>( value[event] ) / static_cast<double>( value[instructions] );
+}
+
+std::string Perf_counters::Reading::summary() const
+{
+  std::ostringstream os;
+  os << std::fixed << std::setprecision(2);
+  auto separator = "";
+  if( valid[cycles] and valid[instructions] ) {
+    os << "IPC " << ipc();
+    separator = ", ";
+  }
+  for( auto event : { cache_misses, branch_misses } ) {
+    if( not valid[event] ) continue;
+    os << separator << per_kilo_instruction( event ) << ' ' << names[event] << "/kinst";
+    separator = ", ";
+  }
+  return os.str();
+}
+
+}//endnamespace Doulos
+
+// TAGS: Doulos, SystemC, performance, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
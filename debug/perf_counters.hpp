@@ -0,0 +1,67 @@
+#pragma once
+
+// Hardware performance counters (cycles, instructions, cache and branch
+// misses) for the calling thread, read as one group via Linux
+// perf_event_open(2). Only user-mode events are requested so the counters work
+// with the default perf_event_paranoid setting.
+//
+// Counters may be unavailable (not Linux, no PMU in a VM, perf_event_paranoid
+// of 3, seccomp in containers...). Construction never fails: check available()
+// and report reason() instead. Events the CPU lacks are left out of the group
+// and read back as invalid.
+//
+// Example:
+//
+//   Doulos::Perf_counters counters;
+//   auto before = counters.read();
+//   work();
+//   auto used = counters.read() - before;
+//   std::cout << used.summary() << '\n'; // "IPC 1.84, 0.52 cache-misses/kinst, ..."
+
+#include <array>
+#include <cstdint>
+#include <string>
+
+namespace Doulos {
+
+class Perf_counters
+{
+public:
+  enum Event { cycles, instructions, cache_misses, branch_misses, events };
+  static constexpr std::array<const char*, events> names{ "cycles", "instructions", "cache-misses", "branch-misses" };
+
+  struct Reading {
+    std::array<std::uint64_t, events> value{};
+    std::array<bool, events>          valid{};
+    Reading& operator+=( const Reading& rhs );
+    friend Reading operator-( Reading lhs, const Reading& rhs ); // counts between two reads
+    double ipc() const;                   // zero unless cycles & instructions are valid
+    double per_kilo_instruction( Event event ) const; // e.g., cache-misses per 1000 instructions
+    std::string summary() const;          // IPC and miss rates
+  };
+
+  Perf_counters(); // counts the calling thread from now on
+  ~Perf_counters();
+  Perf_counters( const Perf_counters& ) = delete;
+  Perf_counters& operator=( const Perf_counters& ) = delete;
+
+  bool               available() const { return m_leader >= 0; }
+  const std::string& reason() const    { return m_reason; } // why not available
+  Reading            read() const;     // scaled if the kernel had to multiplex the group
+
+private:
+  int                      m_leader{ -1 };
+  std::array<int, events>  m_fd{ -1, -1, -1, -1 };
+  std::array<int, events>  m_slot{ -1, -1, -1, -1 }; // position in a group read
+  int                      m_opened{ 0 };
+  std::string              m_reason{};
+};
+
+}//endnamespace Doulos
+
+// TAGS: Doulos, SystemC, performance, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
@@ -0,0 +1,91 @@
+// Check the Chronout formats, including what happens when the caller's buffer
+// is too small.
+//
+// Usage: test_chronout
+//
+// Prints each failing check and exits with 1 if there were any.
+//
+// Does not depend on SystemC.
+
+#include "chronout.hpp"
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <iterator>
+#include <string>
+using namespace std::literals;
+
+namespace {
+
+int checks{ 0 };
+int failures{ 0 };
+
+void check( const std::string& what, const std::string& actual, const std::string& expected )
+{
+  ++checks;
+  if( actual == expected ) return;
+  ++failures;
+  std::cout << "FAILED: " << what << " gave \"" << actual << "\" instead of \"" << expected << "\"\n";
+}
+
+// Formats into exactly size characters, flanked by guards that must survive
+template<typename... Args>
+std::string format_in( std::size_t size, Args... args )
+{
+  char buffer[Chronout::max_size + 2];
+  std::fill( std::begin( buffer ), std::end( buffer ), '#' );
+  auto first = buffer + 1;
+  auto next  = Chronout::format( first, first + size, args... );
+  if( buffer[0] != '#' or first[size] != '#' ) return "(overrun)";
+  if( next < first or next > first + size ) return "(bad pointer)";
+  return { first, next };
+}
+
+}//endnamespace
+
+int main()
+{
+  // Largest unit
+  check( "to_string(500ns)",     Chronout::to_string( 500ns ),          "500.0ns" );
+  check( "to_string(1500us)",    Chronout::to_string( 1500us ),         "1.5ms" );
+  check( "to_string(100s)",      Chronout::to_string( 100s ),           "1.667min" );
+  check( "to_string(2h)",        Chronout::to_string( 2h ),             "2.0h" );
+  check( "to_string(1234ns,1)",  Chronout::to_string( 1234ns, 1 ),      "1.2us" );
+  check( "to_string(1234ns,0)",  Chronout::to_string( 1234ns, 0 ),      "1.0us" );
+
+  // Specific units
+  check( "to_string(1min,ms)",   Chronout::to_string( 1min, 1ms ),      "60000.0ms" );
+  check( "to_string(36h,days)",  Chronout::to_string( 36h, 24h ),       "1.5d" );
+  check( "to_string(2500ms,s)",  Chronout::to_string( 2500ms, 1s ),     "2.5s" );
+
+  // Hours, minutes and seconds
+  check( "to_string(3725.5s,hms)", Chronout::to_string( 3725500ms, Chronout::hms ), "1h2min5.5s" );
+  check( "to_string(2h,hms)",      Chronout::to_string( 2h, Chronout::hms ),        "2h" );
+  check( "to_string(61s,hms)",     Chronout::to_string( 61s, Chronout::hms ),       "1min1.0s" );
+  check( "to_string(42s,hms)",     Chronout::to_string( 42s, Chronout::hms ),       "42.0s" );
+  check( "to_string(59.9996s,hms)", Chronout::to_string( 59999600us, Chronout::hms ), "60.0s" );
+
+  // Caller-supplied buffers: an exact fit, then one character short
+  check( "format(1.5s) in 4",      format_in( 4, Chronout::double_ns_t{ 1500ms } ),              "1.5s" );
+  check( "format(1.5s) in 3",      format_in( 3, Chronout::double_ns_t{ 1500ms } ),              "" );
+  check( "format(1min,ms) in 9",   format_in( 9, Chronout::double_ns_t{ 1min }, Chronout::ns_t{ 1ms } ), "60000.0ms" );
+  check( "format(1min,ms) in 8",   format_in( 8, Chronout::double_ns_t{ 1min }, Chronout::ns_t{ 1ms } ), "" );
+  check( "format(3725.5s,hms) in 10", format_in( 10, Chronout::double_ns_t{ 3725500ms }, Chronout::hms ), "1h2min5.5s" );
+  check( "format(3725.5s,hms) in 9",  format_in( 9,  Chronout::double_ns_t{ 3725500ms }, Chronout::hms ), "" );
+  check( "format(3725.5s,hms) in 2",  format_in( 2,  Chronout::double_ns_t{ 3725500ms }, Chronout::hms ), "" );
+  check( "format(1s) in 0",        format_in( 0, Chronout::double_ns_t{ 1s } ),                  "" );
+
+  if( failures != 0 ) {
+    std::cout << failures << " of " << checks << " checks FAILED\n";
+    return 1;
+  }
+  std::cout << "All " << checks << " checks passed\n";
+  return 0;
+}
+
+// TAGS: Doulos, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2023 Doulos Inc. <mailto:<info@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
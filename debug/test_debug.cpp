@@ -33,11 +33,16 @@ struct Top_module : sc_core::sc_module
                                              );
 
     Debug::parse_command_line();
+    if( Debug::parsed("tExpectBy") ) {
+      // Exactly one warning from this module before the specified time
+      Debug::add_expected( sc_core::SC_WARNING, msg_type, 1, 1, sc_core::SC_ZERO_TIME, Debug::get_time("tExpectBy") );
+    }
   }
 
   void start_of_simulation() override
   {
     Debug::stop_if_requested();
+    Debug::trace( studentGrade, "studentGrade", this );
   }
 
   string studentName{};
@@ -50,6 +55,13 @@ struct Top_module : sc_core::sc_module
     studentStart = Debug::get_time("tStart");
     studentName  = Debug::get_text("sName");
     studentMember = Debug::get_flag("fMember");
+    if( Debug::parsed("tReportAt") ) {
+      wait( Debug::get_time("tReportAt") );
+    }
+    if( Debug::parsed("nDeltas") ) {
+      auto deltas = Debug::get_count("nDeltas");
+      while( deltas-- != 0 ) wait( sc_core::SC_ZERO_TIME ); // e.g., to trip --max-deltas-per-step
+    }
     REPORT_DEBUG( "Starting report..." );
     if ( studentGrade < 70 ) REPORT_ERROR( "You failed the exam!" );
     else if ( studentGrade < 80 ) REPORT_ERROR( "You barely passed" );
@@ -0,0 +1,315 @@
+// Convert a binary trace (--trace-format=bin) into a VCD file for viewing.
+//
+// Usage: trace2vcd INPUT.bin [OUTPUT.vcd]
+//
+// Also accepts delta-resolved traces (--trace-format=delta, INPUT.dlt). VCD
+// cannot show delta cycles, so each time step is stretched into a power of
+// ten of pseudo-time units wide enough for its deltas: a change in the d-th
+// delta of a step appears d units after the step begins. The mapping is noted
+// in a $comment in the output.
+//
+// Does not depend on SystemC.
+
+#include "trace_codec.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+using namespace Doulos::Trace_codec;
+using namespace std::literals;
+
+namespace {
+
+struct Variable {
+  Kind          kind;
+  std::uint64_t width;
+  std::string   name;
+  std::string   code;
+  std::uint64_t previous{ 0 };
+};
+
+std::string vcd_code( std::size_t id )
+{
+  std::string code;
+  do {
+    code += static_cast<char>( '!' + id % 94 );
+    id /= 94;
+  } while( id != 0 );
+  return code;
+}
+
+std::string binary( std::uint64_t value, std::uint64_t width )
+{
+  std::string text;
+  for( auto i = width; i-- > 0; ) text += ( ( i < 64 ) and ( ( value >> i ) & 1 ) ) ? '1' : '0';
+  return text;
+}
+
+int fail( const std::string& message )
+{
+  std::cerr << "Error: " << message << '\n';
+  return 1;
+}
+
+// Variable definitions following the magic number and version
+bool read_variables( const std::uint8_t* in, std::size_t n, std::size_t& pos, std::vector<Variable>& variables )
+{
+  std::uint64_t count;
+  if( not get_varint( in, n, pos, count ) ) return false;
+  for( std::uint64_t id = 0; id < count; ++id ) {
+    Variable variable;
+    std::uint64_t length;
+    if( pos >= n ) return false;
+    variable.kind = static_cast<Kind>( in[pos++] );
+    if( not get_varint( in, n, pos, variable.width ) or not get_varint( in, n, pos, length ) or pos + length > n ) {
+      return false;
+    }
+    variable.name.assign( reinterpret_cast<const char*>( in + pos ), length );
+    variable.code = vcd_code( id );
+    pos += length;
+    variables.push_back( std::move( variable ) );
+  }
+  return true;
+}
+
+void write_definitions( std::ostream& output, const std::vector<Variable>& variables, const std::string& comment = "" )
+{
+  output << "$version trace2vcd $end\n";
+  if( not comment.empty() ) output << "$comment " << comment << " $end\n";
+  output << "$timescale 1 fs $end\n"
+         << "$scope module SystemC $end\n";
+  for( const auto& variable : variables ) {
+    switch( variable.kind ) {
+      case Kind::real:  output << "$var real 64 ";  break;
+      case Kind::event: output << "$var event 1 ";  break;
+      default:          output << "$var wire " << variable.width << ' '; break;
+    }
+    output << variable.code << ' ' << variable.name << " $end\n";
+  }
+  output << "$upscope $end\n$enddefinitions $end\n";
+}
+
+// Value change for all kinds except Kind::bits; value is the decoded sample
+void write_value( std::ostream& output, const Variable& variable, std::uint64_t value )
+{
+  switch( variable.kind ) {
+    case Kind::bit:
+      output << static_cast<char>( '0' + ( value & 1 ) );
+      break;
+    case Kind::logic:
+      output << static_cast<char>( value );
+      break;
+    case Kind::integer:
+      if( variable.width == 1 ) output << ( value & 1 );
+      else output << 'b' << binary( value, variable.width ) << ' ';
+      break;
+    case Kind::real: {
+      double real;
+      std::memcpy( &real, &value, sizeof( real ) );
+      char text[32];
+      std::snprintf( text, sizeof( text ), "%.17g", real );
+      output << 'r' << text << ' ';
+      break;
+    }
+    default: // events
+      output << '1';
+      break;
+  }
+  output << variable.code << '\n';
+}
+
+//------------------------------------------------------------------------------
+// Delta-resolved traces: fixed-size records after the header
+int convert_deltas( const std::vector<std::uint8_t>& file, std::size_t pos
+                  , const std::string& input_name, const std::string& output_name )
+{
+  const auto* in = file.data();
+  const auto  n  = file.size();
+  std::uint64_t file_version, resolution_fs;
+  std::vector<Variable> variables;
+  if( not get_varint( in, n, pos, file_version ) or file_version != delta_version ) {
+    return fail( "Unsupported version in "s + input_name );
+  }
+  if( not get_varint( in, n, pos, resolution_fs ) or not read_variables( in, n, pos, variables ) ) {
+    return fail( "Truncated header in "s + input_name );
+  }
+  const auto count = ( n - pos ) / sizeof( Delta_record );
+  std::vector<Delta_record> records( count );
+  std::memcpy( records.data(), in + pos, count * sizeof( Delta_record ) );
+  auto continuations = [&variables]( const Delta_record& record ) -> std::size_t {
+    if( variables[ record.id ].kind != Kind::bits ) return 0;
+    return ( record.value + delta_digits - 1 ) / delta_digits;
+  };
+
+  // First pass: widest time step in deltas decides the stretch
+  std::uint64_t widest = 0;
+  for( std::size_t i = 0, first = 0; i < count; i += 1 + continuations( records[i] ) ) {
+    if( records[i].id >= variables.size() ) return fail( "Unknown variable in "s + input_name );
+    if( i == 0 or records[i].ticks != records[first].ticks ) first = i;
+    widest = std::max<std::uint64_t>( widest, records[i].delta - records[first].delta ); // modulo 2^32
+  }
+  std::uint64_t stretch = 1;
+  while( stretch <= widest ) stretch *= 10;
+  // Keep real time when a delta unit is still a whole number of fs
+  const bool real_time = ( resolution_fs % stretch == 0 );
+  const auto unit_fs = real_time ? resolution_fs / stretch : std::uint64_t{1};
+  const auto step_fs = real_time ? resolution_fs : stretch;
+
+  std::ofstream output{ output_name };
+  if( not output ) return fail( "Unable to create "s + output_name );
+  write_definitions( output, variables
+                   , "delta cycle d of a time step is shown at step + d * "s + std::to_string( unit_fs ) + " fs"
+                     + ( real_time ? ""s : "; time is stretched by "s + std::to_string( stretch ) ) );
+
+  // Second pass: values
+  std::uint64_t emitted = ~std::uint64_t{0}, changes = 0;
+  std::string bits;
+  for( std::size_t i = 0, first = 0; i < count; ) {
+    const auto& record = records[i];
+    if( i == 0 or record.ticks != records[first].ticks ) first = i;
+    auto time = record.ticks * step_fs + std::uint32_t( record.delta - records[first].delta ) * unit_fs;
+    if( time != emitted ) {
+      output << '#' << time << '\n';
+      emitted = time;
+    }
+    ++changes;
+    const auto& variable = variables[ record.id ];
+    auto extra = continuations( record );
+    if( i + 1 + extra > count ) return fail( "Truncated record in "s + input_name );
+    if( variable.kind == Kind::bits ) {
+      const auto* packed = reinterpret_cast<const std::uint8_t*>( &records[i + 1] );
+      bits.resize( record.value );
+      for( std::size_t k = 0; k < record.value; ++k ) bits[k] = "01zx"[ ( packed[k / 4] >> ( 2 * ( k % 4 ) ) ) & 3 ];
+      output << 'b' << bits << ' ' << variable.code << '\n';
+    }
+    else {
+      write_value( output, variable, record.value );
+    }
+    i += 1 + extra;
+  }
+  std::cout << "Converted " << changes << " value changes of " << variables.size()
+            << " variables spanning up to " << widest + 1 << " deltas per time step from "
+            << input_name << " to " << output_name << '\n';
+  return 0;
+}
+
+}//endnamespace
+
+int main( int argc, char* argv[] )
+{
+  if( argc < 2 or argc > 3 ) {
+    std::cerr << "Usage: trace2vcd INPUT.bin|INPUT.dlt [OUTPUT.vcd]\n";
+    return 1;
+  }
+  auto input_name  = std::string{ argv[1] };
+  auto output_name = ( argc == 3 ) ? std::string{ argv[2] } : input_name.substr( 0, input_name.rfind( '.' ) ) + ".vcd"s;
+
+  std::ifstream input{ input_name, std::ios::binary };
+  if( not input ) return fail( "Unable to open "s + input_name );
+  const std::vector<std::uint8_t> file{ std::istreambuf_iterator<char>{ input }, std::istreambuf_iterator<char>{} };
+  const auto* in = file.data();
+  const auto  n  = file.size();
+
+  //----------------------------------------------------------------------------
+  // Header
+  //............................................................................
+  auto file_magic = ( n < magic_size ) ? ""s : std::string( file.begin(), file.begin() + magic_size );
+  if( file_magic == delta_magic ) return convert_deltas( file, magic_size, input_name, output_name );
+  if( file_magic != magic ) {
+    return fail( input_name + " is not a binary trace file"s );
+  }
+  std::size_t pos = magic_size;
+  std::uint64_t file_version, resolution_fs;
+  if( not get_varint( in, n, pos, file_version ) or file_version != version ) {
+    return fail( "Unsupported version in "s + input_name );
+  }
+  std::vector<Variable> variables;
+  if( not get_varint( in, n, pos, resolution_fs ) or not read_variables( in, n, pos, variables ) ) {
+    return fail( "Truncated header in "s + input_name );
+  }
+
+  std::ofstream output{ output_name };
+  if( not output ) return fail( "Unable to create "s + output_name );
+  write_definitions( output, variables );
+
+  //----------------------------------------------------------------------------
+  // Blocks
+  //............................................................................
+  std::vector<std::uint8_t> raw;
+  std::string bits;
+  std::uint64_t ticks = 0, emitted = ~std::uint64_t{0}, changes = 0;
+  while( pos < n ) {
+    std::uint64_t raw_size, stored_size;
+    if( not get_varint( in, n, pos, raw_size ) or not get_varint( in, n, pos, stored_size ) or pos + stored_size > n ) {
+      return fail( "Truncated block in "s + input_name );
+    }
+    raw.clear();
+    if( stored_size == raw_size ) raw.assign( in + pos, in + pos + stored_size );
+    else if( not decompress( in + pos, stored_size, raw ) or raw.size() != raw_size ) {
+      return fail( "Corrupt block in "s + input_name );
+    }
+    pos += stored_size;
+
+    std::size_t at = 0;
+    const auto* data = raw.data();
+    ticks = 0; // blocks are self-contained (see trace_codec.hpp)
+    for( auto& variable : variables ) variable.previous = 0;
+    while( at < raw.size() ) {
+      std::uint64_t code, value;
+      if( not get_varint( data, raw.size(), at, code ) ) return fail( "Corrupt record in "s + input_name );
+      if( code == 0 ) {
+        if( not get_varint( data, raw.size(), at, value ) ) return fail( "Corrupt record in "s + input_name );
+        ticks += value;
+        continue;
+      }
+      if( code > variables.size() ) return fail( "Unknown variable in "s + input_name );
+      auto& variable = variables[code - 1];
+      if( ticks != emitted ) {
+        output << '#' << ticks * resolution_fs << '\n';
+        emitted = ticks;
+      }
+      ++changes;
+      switch( variable.kind ) {
+        case Kind::bit:
+        case Kind::logic:
+          if( at >= raw.size() ) return fail( "Corrupt record in "s + input_name );
+          write_value( output, variable, data[at++] );
+          break;
+        case Kind::integer:
+          if( not get_varint( data, raw.size(), at, value ) ) return fail( "Corrupt record in "s + input_name );
+          variable.previous += static_cast<std::uint64_t>( unzigzag( value ) );
+          write_value( output, variable, variable.previous );
+          break;
+        case Kind::real:
+          if( not get_varint( data, raw.size(), at, value ) ) return fail( "Corrupt record in "s + input_name );
+          variable.previous ^= value;
+          write_value( output, variable, variable.previous );
+          break;
+        case Kind::bits:
+          if( not get_bits( data, raw.size(), at, bits ) ) return fail( "Corrupt record in "s + input_name );
+          output << 'b' << bits << ' ' << variable.code << '\n';
+          break;
+        case Kind::event:
+          write_value( output, variable, 1 );
+          break;
+        default:
+          return fail( "Unknown variable kind in "s + input_name );
+      }
+    }
+  }
+  std::cout << "Converted " << changes << " value changes of " << variables.size()
+            << " variables from " << input_name << " to " << output_name << '\n';
+  return 0;
+}
+
+// TAGS: Doulos, SystemC, trace, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
@@ -0,0 +1,205 @@
+#pragma once
+
+// Encoding helpers shared by the binary trace writer (trace_file.cpp) and the
+// stand-alone converter (trace2vcd.cpp). Deliberately free of SystemC so the
+// converter can be built and run anywhere.
+//
+// File layout (all integers are LEB128 varints unless noted):
+//
+//   "DBGTRACE" version resolution_fs variable_count
+//   variable_count x { kind width name_length name_bytes }
+//   blocks...
+//
+// Each block is { raw_size stored_size data }, where data is LZ compressed
+// unless stored_size == raw_size. Decompressed blocks hold records:
+//
+//   0 ticks_delta                   advance time
+//   id+1 value                      value change for variable id
+//
+// Every block starts afresh: time and value deltas are relative to zero at
+// the start of a block, so a tool can start decoding at any block offset
+// listed in a segment index (.idx).
+//
+// Values are encoded by kind: bit/logic as one byte, integer as a zigzag
+// delta from the previous value, real as XOR with the previous bit pattern,
+// bits as a length followed by 2-bit packed digits (0,1,z,x), and events
+// carry no payload.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace Doulos::Trace_codec {
+
+constexpr const char magic[] = "DBGTRACE";
+constexpr std::size_t magic_size = sizeof(magic) - 1;
+constexpr std::uint64_t version = 2;
+constexpr std::size_t block_size = 64 * 1024; // raw bytes per compressed block
+
+// Delta-resolved traces (--trace-format=delta) share the header layout, but
+// are followed by uncompressed fixed-size records in native byte order.
+constexpr const char delta_magic[] = "DBGDELTA";
+constexpr std::uint64_t delta_version = 1;
+struct Delta_record {
+  std::uint64_t ticks; // kernel resolution units
+  std::uint32_t delta; // low 32 bits of sc_delta_count()
+  std::uint32_t id;    // variable; Kind::bits values are followed by records of packed digits
+  std::uint64_t value; // Kind::bits: number of digits
+};
+constexpr std::size_t delta_digits = 4 * sizeof( Delta_record ); // per continuation record
+
+// Transaction records (see tx_recorder.hpp) use the same block framing
+constexpr const char tx_magic[] = "DBGTXREC";
+constexpr std::uint64_t tx_version = 1;
+enum Tx_record : std::uint8_t { tx_stream, tx_begin, tx_end };
+
+enum class Kind : std::uint8_t { bit, logic, integer, real, bits, event };
+
+//------------------------------------------------------------------------------
+inline void put_varint( std::vector<std::uint8_t>& out, std::uint64_t value )
+{
+  while( value >= 0x80 ) {
+    out.push_back( static_cast<std::uint8_t>( value | 0x80 ) );
+    value >>= 7;
+  }
+  out.push_back( static_cast<std::uint8_t>( value ) );
+}
+
+// Returns false if the input is exhausted or malformed
+inline bool get_varint( const std::uint8_t* in, std::size_t n, std::size_t& pos, std::uint64_t& value )
+{
+  value = 0;
+  for( int shift = 0; shift < 64; shift += 7 ) {
+    if( pos >= n ) return false;
+    auto byte = in[pos++];
+    value |= std::uint64_t{ byte & 0x7fu } << shift;
+    if( ( byte & 0x80 ) == 0 ) return true;
+  }
+  return false;
+}
+
+inline std::uint64_t zigzag( std::int64_t value )
+{
+  return ( static_cast<std::uint64_t>( value ) << 1 ) ^ static_cast<std::uint64_t>( value >> 63 );
+}
+
+inline std::int64_t unzigzag( std::uint64_t value )
+{
+  return static_cast<std::int64_t>( value >> 1 ) ^ -static_cast<std::int64_t>( value & 1 );
+}
+
+//------------------------------------------------------------------------------
+// Minimal LZ77 byte codec. Tokens are either a literal run (0x00-0x7f: run-1
+// followed by the bytes) or a match (0x80 | length-4, then varint distance).
+// Favors speed over ratio; trace records are highly repetitive so this is
+// usually enough to shrink them several-fold.
+inline void compress( const std::uint8_t* in, std::size_t n, std::vector<std::uint8_t>& out )
+{
+  constexpr std::size_t min_match = 4;
+  constexpr std::size_t max_match = min_match + 0x7f;
+  constexpr int         hash_bits = 13;
+  constexpr auto        empty     = UINT32_MAX;
+  std::vector<std::uint32_t> table( std::size_t{1} << hash_bits, empty );
+  out.clear();
+  std::size_t literal_start = 0;
+  auto flush_literals = [&]( std::size_t end ) {
+    while( literal_start < end ) {
+      auto run = std::min<std::size_t>( end - literal_start, 0x80 );
+      out.push_back( static_cast<std::uint8_t>( run - 1 ) );
+      out.insert( out.end(), in + literal_start, in + literal_start + run );
+      literal_start += run;
+    }
+  };
+  std::size_t i = 0;
+  while( i + min_match <= n ) {
+    std::uint32_t sequence;
+    std::memcpy( &sequence, in + i, sizeof(sequence) );
+    auto hash = ( sequence * 2654435761u ) >> ( 32 - hash_bits );
+    auto candidate = table[hash];
+    table[hash] = static_cast<std::uint32_t>( i );
+    if( candidate != empty and std::memcmp( in + candidate, in + i, min_match ) == 0 ) {
+      auto length = min_match;
+      while( i + length < n and length < max_match and in[candidate + length] == in[i + length] ) ++length;
+      flush_literals( i );
+      out.push_back( static_cast<std::uint8_t>( 0x80 | ( length - min_match ) ) );
+      put_varint( out, i - candidate );
+      i += length;
+      literal_start = i;
+    }
+    else {
+      ++i;
+    }
+  }
+  flush_literals( n );
+}
+
+// Appends to out; returns false on malformed input
+inline bool decompress( const std::uint8_t* in, std::size_t n, std::vector<std::uint8_t>& out )
+{
+  std::size_t pos = 0;
+  while( pos < n ) {
+    auto token = in[pos++];
+    if( token < 0x80 ) {
+      std::size_t run = token + 1u;
+      if( pos + run > n ) return false;
+      out.insert( out.end(), in + pos, in + pos + run );
+      pos += run;
+    }
+    else {
+      std::size_t length = ( token & 0x7fu ) + 4u;
+      std::uint64_t distance;
+      if( not get_varint( in, n, pos, distance ) or distance == 0 or distance > out.size() ) return false;
+      auto from = out.size() - distance;
+      for( std::size_t k = 0; k < length; ++k ) {
+        auto byte = out[from + k]; // may overlap what is being written
+        out.push_back( byte );
+      }
+    }
+  }
+  return true;
+}
+
+//------------------------------------------------------------------------------
+// 2-bit packing of '0','1','z','x' digit strings (MSB first)
+inline void put_bits( std::vector<std::uint8_t>& out, const std::string& bits )
+{
+  put_varint( out, bits.size() );
+  std::uint8_t packed = 0;
+  for( std::size_t i = 0; i < bits.size(); ++i ) {
+    std::uint8_t digit;
+    switch( bits[i] ) {
+      case '0': digit = 0; break;
+      case '1': digit = 1; break;
+      case 'z': case 'Z': digit = 2; break;
+      default:  digit = 3; break;
+    }
+    packed |= digit << ( 2 * ( i % 4 ) );
+    if( i % 4 == 3 ) { out.push_back( packed ); packed = 0; }
+  }
+  if( bits.size() % 4 != 0 ) out.push_back( packed );
+}
+
+inline bool get_bits( const std::uint8_t* in, std::size_t n, std::size_t& pos, std::string& bits )
+{
+  std::uint64_t width;
+  if( not get_varint( in, n, pos, width ) ) return false;
+  auto bytes = ( width + 3 ) / 4;
+  if( pos + bytes > n ) return false;
+  bits.resize( width );
+  for( std::size_t i = 0; i < width; ++i ) {
+    bits[i] = "01zx"[ ( in[pos + i / 4] >> ( 2 * ( i % 4 ) ) ) & 3 ];
+  }
+  pos += bytes;
+  return true;
+}
+
+}//endnamespace Doulos::Trace_codec
+
+// TAGS: Doulos, SystemC, trace, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
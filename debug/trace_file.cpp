@@ -0,0 +1,937 @@
+#include "trace_file.hpp"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+using namespace sc_core;
+using namespace sc_dt;
+
+namespace Doulos {
+
+//------------------------------------------------------------------------------
+// Samplers capture a reference to the traced object and report changes.
+struct Trace_file::Sample {
+  virtual ~Sample() = default;
+  virtual bool update() = 0; // true if the value changed since last call
+  std::uint64_t word{};      // all kinds except Kind::bits
+  std::string   bits{};      // Kind::bits (MSB first)
+};
+
+namespace {
+
+template<typename F>
+struct Word_sample final : Trace_file::Sample {
+  explicit Word_sample( F f ) : m_read{ std::move( f ) } {}
+  bool update() override {
+    auto value = m_read();
+    if( value == word ) return false;
+    word = value;
+    return true;
+  }
+  F m_read;
+};
+
+template<typename F>
+struct Bits_sample final : Trace_file::Sample {
+  explicit Bits_sample( F f ) : m_read{ std::move( f ) } {}
+  bool update() override {
+    m_scratch.clear();
+    m_read( m_scratch );
+    if( m_scratch == bits ) return false;
+    bits.swap( m_scratch );
+    return true;
+  }
+  F           m_read;
+  std::string m_scratch;
+};
+
+std::uint64_t masked( std::uint64_t value, int width )
+{
+  if( width <= 0 or width >= 64 ) return value;
+  return value & ( ( std::uint64_t{1} << width ) - 1 );
+}
+
+std::uint64_t real_bits( double value )
+{
+  std::uint64_t word;
+  std::memcpy( &word, &value, sizeof( word ) );
+  return word;
+}
+
+// Header shared by the binary formats (see trace_codec.hpp)
+std::vector<std::uint8_t> encode_header( const char* magic, std::uint64_t version, std::uint64_t resolution_fs
+                                       , const std::vector<Trace_file::Variable>& variables )
+{
+  using namespace Trace_codec;
+  std::vector<std::uint8_t> header{ magic, magic + magic_size };
+  put_varint( header, version );
+  put_varint( header, resolution_fs );
+  put_varint( header, variables.size() );
+  for( const auto& variable : variables ) {
+    header.push_back( static_cast<std::uint8_t>( variable.kind ) );
+    put_varint( header, static_cast<std::uint64_t>( variable.width ) );
+    put_varint( header, variable.name.size() );
+    header.insert( header.end(), variable.name.begin(), variable.name.end() );
+  }
+  return header;
+}
+
+// 2-bit packing of digits into raw memory (MSB first; see Trace_codec::put_bits)
+void pack_digits( const std::string& bits, std::uint8_t* packed )
+{
+  for( std::size_t i = 0; i < bits.size(); ++i ) {
+    std::uint8_t digit;
+    switch( bits[i] ) {
+      case '0': digit = 0; break;
+      case '1': digit = 1; break;
+      case 'z': case 'Z': digit = 2; break;
+      default:  digit = 3; break;
+    }
+    packed[ i / 4 ] |= digit << ( 2 * ( i % 4 ) );
+  }
+}
+
+// Short VCD identifier codes: !, ", #, ... then two characters
+std::string vcd_code( std::size_t id )
+{
+  std::string code;
+  do {
+    code += static_cast<char>( '!' + id % 94 );
+    id /= 94;
+  } while( id != 0 );
+  return code;
+}
+
+// VCD only allows 1, 10 or 100 of a unit
+std::string vcd_timescale( std::uint64_t resolution_fs )
+{
+  static const std::pair<const char*, std::uint64_t> units[] = {
+    { "s", 1'000'000'000'000'000 }, { "ms", 1'000'000'000'000 }, { "us", 1'000'000'000 },
+    { "ns", 1'000'000 }, { "ps", 1'000 }, { "fs", 1 },
+  };
+  for( const auto& [ unit, fs ] : units ) {
+    if( resolution_fs < fs or resolution_fs % fs != 0 ) continue;
+    auto count = resolution_fs / fs;
+    if( count == 1 or count == 10 or count == 100 ) return std::to_string( count ) + " " + unit;
+  }
+  return std::to_string( resolution_fs ) + " fs";
+}
+
+}//endnamespace
+
+//------------------------------------------------------------------------------
+Trace_file::Trace_file( const char* name, const char* extension )
+: sc_trace_file_base{ name, extension }
+, m_name{ name }
+, m_extension{ extension }
+{
+}
+
+Trace_file::~Trace_file()
+{
+  if( m_index != nullptr ) std::fclose( m_index );
+}
+
+//..............................................................................
+void Trace_file::set_segments( const sc_time& period, std::uint64_t max_bytes )
+{
+  m_segment_period = period;
+  m_segment_limit  = max_bytes;
+}
+
+std::string Trace_file::segment_name( std::size_t segment ) const
+{
+  if( segment == 0 ) return m_name + "." + m_extension;
+  char suffix[32];
+  std::snprintf( suffix, sizeof( suffix ), "-%04zu.", segment );
+  return m_name + suffix + m_extension;
+}
+
+// May be called from a writer thread, but only ever from one thread
+void Trace_file::index( const std::string& file, sc_dt::uint64 ticks, std::uint64_t offset )
+{
+  if( not segmenting() ) return;
+  if( m_index == nullptr ) {
+    m_index = std::fopen( ( m_name + ".idx" ).c_str(), "w" );
+    if( m_index == nullptr ) return;
+    std::fputs( "# file time_fs byte_offset\n", m_index );
+  }
+  std::fprintf( m_index, "%s %llu %llu\n", file.c_str()
+              , static_cast<unsigned long long>( ticks * m_resolution_fs )
+              , static_cast<unsigned long long>( offset )
+              );
+}
+
+template<typename Sampler>
+void Trace_file::add( const std::string& name, Kind kind, int width, Sampler&& sampler )
+{
+  if( not add_trace_check( name ) ) return;
+  using F = std::decay_t<Sampler>;
+  if constexpr( std::is_invocable_v<F, std::string&> ) {
+    m_samples.emplace_back( new Bits_sample<F>{ std::forward<Sampler>( sampler ) } );
+  }
+  else {
+    m_samples.emplace_back( new Word_sample<F>{ std::forward<Sampler>( sampler ) } );
+  }
+  m_variables.push_back( Variable{ name, kind, width } );
+}
+
+void Trace_file::emit( std::size_t id )
+{
+  if( m_variables[id].kind == Kind::bits ) write_value( id, m_samples[id]->bits );
+  else                                     write_value( id, m_samples[id]->word );
+}
+
+//..............................................................................
+void Trace_file::do_initialize()
+{
+  m_resolution_fs = static_cast<std::uint64_t>( sc_get_time_resolution().to_seconds() * 1e15 + 0.5 );
+  m_segment_start = sc_time_stamp();
+  write_header();
+  snapshot( true );
+}
+
+//..............................................................................
+void Trace_file::snapshot( bool initial )
+{
+  write_time( sc_time_stamp().value() );
+  for( std::size_t id = 0; id < m_samples.size(); ++id ) {
+    auto changed = m_samples[id]->update();
+    // Events have no value, so only report those that just occurred
+    if( m_variables[id].kind != Kind::event or ( changed and not initial ) ) emit( id );
+  }
+}
+
+//..............................................................................
+void Trace_file::segment_opened()
+{
+  m_segment_origin = m_written.load();
+  ++m_segments_opened;
+}
+
+std::uint64_t Trace_file::segment_bytes()
+{
+  if( m_segments_opened.load() != m_segment ) return 0; // writer has not caught up
+  return m_written.load() - m_segment_origin.load();
+}
+
+bool Trace_file::segment_due()
+{
+  if( m_segment_period != SC_ZERO_TIME and sc_time_stamp() >= m_segment_start + m_segment_period ) return true;
+  return m_segment_limit != 0 and segment_bytes() >= m_segment_limit;
+}
+
+//..............................................................................
+void Trace_file::cycle( bool delta_cycle )
+{
+  if( delta_cycle and not delta_cycles() ) return;
+  if( initialize() ) return;
+  if( segmenting() and segment_due() ) {
+    m_segment_start = sc_time_stamp();
+    start_segment( segment_name( ++m_segment ) );
+    write_header();
+    snapshot( false );
+    return;
+  }
+  bool stamped = false;
+  for( std::size_t id = 0; id < m_samples.size(); ++id ) {
+    if( not m_samples[id]->update() ) continue;
+    if( not stamped ) {
+      write_time( sc_time_stamp().value() );
+      stamped = true;
+    }
+    emit( id );
+  }
+}
+
+//..............................................................................
+void Trace_file::write_comment( const std::string& )
+{
+  // Comments are not recorded by these writers
+}
+
+//------------------------------------------------------------------------------
+// sc_trace_file overloads
+//..............................................................................
+void Trace_file::trace( const sc_event& object, const std::string& name )
+{
+  add( name, Kind::event, 1, [this,&object]{ return std::uint64_t{ event_trigger_stamp( object ) }; } );
+}
+
+void Trace_file::trace( const sc_time& object, const std::string& name )
+{
+  add( name, Kind::integer, 64, [&object]{ return std::uint64_t{ object.value() }; } );
+}
+
+void Trace_file::trace( const bool& object, const std::string& name )
+{
+  add( name, Kind::bit, 1, [&object]{ return std::uint64_t{ object ? 1u : 0u }; } );
+}
+
+void Trace_file::trace( const sc_bit& object, const std::string& name )
+{
+  add( name, Kind::bit, 1, [&object]{ return std::uint64_t{ object.to_bool() ? 1u : 0u }; } );
+}
+
+void Trace_file::trace( const sc_logic& object, const std::string& name )
+{
+  add( name, Kind::logic, 1, [&object]{
+    return static_cast<std::uint64_t>( std::tolower( object.to_char() ) );
+  } );
+}
+
+#define DOULOS_TRACE_INTEGER( tp )                                                   \
+void Trace_file::trace( const tp& object, const std::string& name, int width )       \
+{                                                                                    \
+  add( name, Kind::integer, width, [&object,width]{                                  \
+    return masked( static_cast<std::uint64_t>( object ), width );                    \
+  } );                                                                               \
+}
+DOULOS_TRACE_INTEGER( unsigned char )
+DOULOS_TRACE_INTEGER( unsigned short )
+DOULOS_TRACE_INTEGER( unsigned int )
+DOULOS_TRACE_INTEGER( unsigned long )
+DOULOS_TRACE_INTEGER( char )
+DOULOS_TRACE_INTEGER( short )
+DOULOS_TRACE_INTEGER( int )
+DOULOS_TRACE_INTEGER( long )
+DOULOS_TRACE_INTEGER( sc_dt::int64 )
+DOULOS_TRACE_INTEGER( sc_dt::uint64 )
+#undef DOULOS_TRACE_INTEGER
+
+void Trace_file::trace( const unsigned int& object, const std::string& name, const char** )
+{
+  trace( object, name, 32 ); // literals are not recorded
+}
+
+void Trace_file::trace( const sc_int_base& object, const std::string& name )
+{
+  auto width = object.length();
+  add( name, Kind::integer, width, [&object,width]{
+    return masked( static_cast<std::uint64_t>( object.value() ), width );
+  } );
+}
+
+void Trace_file::trace( const sc_uint_base& object, const std::string& name )
+{
+  add( name, Kind::integer, object.length(), [&object]{ return std::uint64_t{ object.value() }; } );
+}
+
+#define DOULOS_TRACE_REAL( tp )                                                      \
+void Trace_file::trace( const tp& object, const std::string& name )                  \
+{                                                                                    \
+  add( name, Kind::real, 64, [&object]{ return real_bits( object ); } );             \
+}
+DOULOS_TRACE_REAL( float )
+DOULOS_TRACE_REAL( double )
+#undef DOULOS_TRACE_REAL
+
+#define DOULOS_TRACE_FIXED( tp )                                                     \
+void Trace_file::trace( const tp& object, const std::string& name )                  \
+{                                                                                    \
+  add( name, Kind::real, 64, [&object]{ return real_bits( object.to_double() ); } ); \
+}
+DOULOS_TRACE_FIXED( sc_fxval )
+DOULOS_TRACE_FIXED( sc_fxval_fast )
+DOULOS_TRACE_FIXED( sc_fxnum )
+DOULOS_TRACE_FIXED( sc_fxnum_fast )
+#undef DOULOS_TRACE_FIXED
+
+#define DOULOS_TRACE_BIGNUM( tp )                                                    \
+void Trace_file::trace( const tp& object, const std::string& name )                  \
+{                                                                                    \
+  add( name, Kind::bits, object.length(), [&object]( std::string& bits ){            \
+    for( auto i = object.length(); i-- > 0; ) bits += object.test( i ) ? '1' : '0';  \
+  } );                                                                               \
+}
+DOULOS_TRACE_BIGNUM( sc_signed )
+DOULOS_TRACE_BIGNUM( sc_unsigned )
+#undef DOULOS_TRACE_BIGNUM
+
+#define DOULOS_TRACE_VECTOR( tp )                                                    \
+void Trace_file::trace( const tp& object, const std::string& name )                  \
+{                                                                                    \
+  add( name, Kind::bits, object.length(), [&object]( std::string& bits ){            \
+    for( auto i = object.length(); i-- > 0; ) {                                      \
+      bits += "01zx"[ static_cast<int>( object.get_bit( i ) ) & 3 ];                 \
+    }                                                                                \
+  } );                                                                               \
+}
+DOULOS_TRACE_VECTOR( sc_bv_base )
+DOULOS_TRACE_VECTOR( sc_lv_base )
+#undef DOULOS_TRACE_VECTOR
+
+//------------------------------------------------------------------------------
+// Binary writer
+//..............................................................................
+Bin_trace_file::Bin_trace_file( const char* name )
+: Trace_file{ name, "bin" }
+{
+}
+
+Bin_trace_file::~Bin_trace_file()
+{
+  if( m_thread.joinable() ) {
+    flush_block();
+    {
+      std::lock_guard<std::mutex> lock{ m_mutex };
+      m_done = true;
+    }
+    m_ready.notify_one();
+    m_thread.join();
+  }
+  // sc_trace_file_base closes fp
+}
+
+//..............................................................................
+void Bin_trace_file::do_initialize()
+{
+  if( fp != nullptr ) { // otherwise open_fp() already reported the problem
+    std::setvbuf( fp, nullptr, _IOFBF, 4 * Trace_codec::block_size ); // buffered; never synced
+    m_thread = std::thread{ [this]{ compressor(); } };
+  }
+  Trace_file::do_initialize();
+}
+
+//..............................................................................
+void Bin_trace_file::write_header()
+{
+  Chunk chunk{ encode_header( Trace_codec::magic, Trace_codec::version, resolution_fs(), variables() ) };
+  chunk.header = true;
+  chunk.file.swap( m_next_file );
+  push( std::move( chunk ) );
+  m_previous.assign( variables().size(), 0 );
+}
+
+//..............................................................................
+// Blocks are self-contained: absolute time first and deltas restart from zero
+void Bin_trace_file::start_block()
+{
+  m_block.reserve( Trace_codec::block_size + 64 );
+  m_previous.assign( variables().size(), 0 );
+  m_block_ticks = m_ticks;
+  m_last_ticks = m_ticks;
+  Trace_codec::put_varint( m_block, 0 );
+  Trace_codec::put_varint( m_block, m_ticks );
+}
+
+//..............................................................................
+void Bin_trace_file::write_time( sc_dt::uint64 ticks )
+{
+  m_ticks = ticks;
+  if( m_block.empty() ) {
+    start_block();
+    return;
+  }
+  Trace_codec::put_varint( m_block, 0 );
+  Trace_codec::put_varint( m_block, ticks - m_last_ticks );
+  m_last_ticks = ticks;
+  if( m_block.size() >= Trace_codec::block_size ) flush_block();
+}
+
+//..............................................................................
+void Bin_trace_file::write_value( std::size_t id, std::uint64_t word )
+{
+  using namespace Trace_codec;
+  if( m_block.empty() ) start_block();
+  put_varint( m_block, id + 1 );
+  switch( variables()[id].kind ) {
+    case Kind::bit:
+    case Kind::logic:
+      m_block.push_back( static_cast<std::uint8_t>( word ) );
+      break;
+    case Kind::integer:
+      put_varint( m_block, zigzag( static_cast<std::int64_t>( word - m_previous[id] ) ) );
+      break;
+    case Kind::real:
+      put_varint( m_block, word ^ m_previous[id] );
+      break;
+    default: // events carry no payload
+      break;
+  }
+  m_previous[id] = word;
+  if( m_block.size() >= block_size ) flush_block();
+}
+
+//..............................................................................
+void Bin_trace_file::write_value( std::size_t id, const std::string& bits )
+{
+  if( m_block.empty() ) start_block();
+  Trace_codec::put_varint( m_block, id + 1 );
+  Trace_codec::put_bits( m_block, bits );
+  if( m_block.size() >= Trace_codec::block_size ) flush_block();
+}
+
+//..............................................................................
+void Bin_trace_file::start_segment( const std::string& filename )
+{
+  flush_block();
+  m_next_file = filename; // picked up by the next write_header()
+}
+
+//..............................................................................
+// Hand the current block to the compressor thread
+void Bin_trace_file::flush_block()
+{
+  if( m_block.empty() ) return;
+  Chunk chunk;
+  chunk.data.swap( m_block );
+  chunk.ticks = m_block_ticks;
+  push( std::move( chunk ) );
+}
+
+void Bin_trace_file::push( Chunk&& chunk )
+{
+  if( not m_thread.joinable() ) return; // file could not be opened
+  {
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    m_queue.push_back( std::move( chunk ) );
+  }
+  m_ready.notify_one();
+}
+
+//..............................................................................
+// Runs on a separate thread: after do_initialize() the only user of fp
+void Bin_trace_file::compressor()
+{
+  auto file   = segment_name( 0 );
+  auto offset = std::uint64_t{ 0 };
+  auto write  = [this,&offset]( const Block& data ) {
+    if( fp != nullptr ) std::fwrite( data.data(), 1, data.size(), fp );
+    offset += data.size();
+    written( data.size() );
+  };
+  Block compressed;
+  Block header;
+  for(;;) {
+    Chunk chunk;
+    {
+      std::unique_lock<std::mutex> lock{ m_mutex };
+      m_ready.wait( lock, [this]{ return m_done or not m_queue.empty(); } );
+      if( m_queue.empty() ) return; // done and drained
+      chunk = std::move( m_queue.front() );
+      m_queue.pop_front();
+    }
+    if( chunk.header ) {
+      if( not chunk.file.empty() ) {
+        if( fp != nullptr ) std::fclose( fp );
+        fp = std::fopen( chunk.file.c_str(), "wb" );
+        if( fp != nullptr ) std::setvbuf( fp, nullptr, _IOFBF, 4 * Trace_codec::block_size );
+        file   = chunk.file;
+        offset = 0;
+        segment_opened();
+      }
+      write( chunk.data );
+      continue;
+    }
+    const auto& raw = chunk.data;
+    Trace_codec::compress( raw.data(), raw.size(), compressed );
+    const auto& data = ( compressed.size() < raw.size() ) ? compressed : raw;
+    index( file, chunk.ticks, offset );
+    header.clear();
+    Trace_codec::put_varint( header, raw.size() );
+    Trace_codec::put_varint( header, data.size() );
+    write( header );
+    write( data );
+  }
+}
+
+//------------------------------------------------------------------------------
+Vcd_trace_file::Vcd_trace_file( const char* name )
+: Trace_file{ name, "vcd" }
+{
+}
+
+Vcd_trace_file::~Vcd_trace_file()
+{
+  if( m_thread.joinable() ) {
+    m_done.store( true, std::memory_order_release );
+    m_thread.join();
+  }
+  // sc_trace_file_base closes fp
+}
+
+//..............................................................................
+void Vcd_trace_file::do_initialize()
+{
+  m_codes.clear();
+  for( std::size_t id = 0; id < variables().size(); ++id ) m_codes.push_back( vcd_code( id ) );
+  if( fp != nullptr ) { // otherwise open_fp() already reported the problem
+    std::setvbuf( fp, nullptr, _IOFBF, 256 * 1024 ); // buffered; never synced
+    m_thread = std::thread{ [this]{ formatter(); } };
+  }
+  Trace_file::do_initialize();
+}
+
+//..............................................................................
+void Vcd_trace_file::push( const Record* records, std::size_t count )
+{
+  if( m_thread.joinable() ) m_ring.push( records, count ); // else the file could not be opened
+}
+
+void Vcd_trace_file::write_header()
+{
+  Record record{ header_marker, 0, 0 };
+  push( &record, 1 );
+}
+
+void Vcd_trace_file::write_time( sc_dt::uint64 ticks )
+{
+  Record record{ time_marker, 0, ticks };
+  push( &record, 1 );
+}
+
+void Vcd_trace_file::write_value( std::size_t id, std::uint64_t word )
+{
+  Record record{ static_cast<std::uint32_t>( id ), 0, word };
+  push( &record, 1 );
+}
+
+void Vcd_trace_file::write_value( std::size_t id, const std::string& bits )
+{
+  constexpr std::size_t digits_per_slot = 4 * sizeof( Record );
+  const auto extra = ( bits.size() + digits_per_slot - 1 ) / digits_per_slot;
+  m_scratch.assign( 1 + extra, Record{ 0, 0, 0 } );
+  m_scratch[0] = Record{ static_cast<std::uint32_t>( id ), static_cast<std::uint32_t>( extra ), bits.size() };
+  pack_digits( bits, reinterpret_cast<std::uint8_t*>( m_scratch.data() + 1 ) );
+  push( m_scratch.data(), m_scratch.size() );
+}
+
+//..............................................................................
+void Vcd_trace_file::start_segment( const std::string& filename )
+{
+  {
+    std::lock_guard<std::mutex> lock{ m_mutex };
+    m_files.push_back( filename );
+  }
+  // The header_marker that Trace_file writes next tells the formatter to switch
+}
+
+//..............................................................................
+void Vcd_trace_file::format_header( std::string& text ) const
+{
+  text += "$version Doulos debugaid $end\n";
+  text += "$timescale " + vcd_timescale( resolution_fs() ) + " $end\n";
+  // Sorting keeps every scope contiguous so each is opened exactly once
+  std::vector<std::size_t> order( variables().size() );
+  for( std::size_t id = 0; id < order.size(); ++id ) order[id] = id;
+  std::sort( order.begin(), order.end(), [this]( auto lhs, auto rhs ){
+    return variables()[lhs].name < variables()[rhs].name;
+  } );
+  std::vector<std::string> open{ "SystemC" };
+  text += "$scope module SystemC $end\n";
+  for( auto id : order ) {
+    const auto& variable = variables()[id];
+    std::vector<std::string> scopes{ "SystemC" };
+    std::size_t start = 0;
+    for( auto dot = variable.name.find( '.' ); dot != std::string::npos; dot = variable.name.find( '.', start ) ) {
+      scopes.push_back( variable.name.substr( start, dot - start ) );
+      start = dot + 1;
+    }
+    std::size_t common = 0;
+    while( common < open.size() and common < scopes.size() and open[common] == scopes[common] ) ++common;
+    for( ; open.size() > common; open.pop_back() ) text += "$upscope $end\n";
+    for( ; open.size() < scopes.size(); open.push_back( scopes[ open.size() ] ) ) {
+      text += "$scope module " + scopes[ open.size() ] + " $end\n";
+    }
+    switch( variable.kind ) {
+      case Kind::real:  text += "$var real 64 "; break;
+      case Kind::event: text += "$var event 1 "; break;
+      default:          text += "$var wire " + std::to_string( variable.width ) + " "; break;
+    }
+    text += m_codes[id] + " " + variable.name.substr( start ) + " $end\n";
+  }
+  for( ; not open.empty(); open.pop_back() ) text += "$upscope $end\n";
+  text += "$enddefinitions $end\n";
+}
+
+//..............................................................................
+void Vcd_trace_file::format_value( std::string& text, std::size_t slot ) const
+{
+  const auto& record   = m_ring[ slot ];
+  const auto& variable = variables()[ record.id ];
+  switch( variable.kind ) {
+    case Kind::bit:
+      text += static_cast<char>( '0' + ( record.word & 1 ) );
+      break;
+    case Kind::logic:
+      text += static_cast<char>( record.word );
+      break;
+    case Kind::integer:
+      if( variable.width == 1 ) {
+        text += static_cast<char>( '0' + ( record.word & 1 ) );
+        break;
+      }
+      text += 'b';
+      for( int i = std::min( variable.width, 64 ) - 1; i >= 0; --i ) {
+        auto one = ( record.word >> i ) & 1;
+        if( one != 0 or i == 0 or text.back() != 'b' ) text += static_cast<char>( '0' + one ); // no leading zeros
+      }
+      text += ' ';
+      break;
+    case Kind::real: {
+      double real;
+      std::memcpy( &real, &record.word, sizeof( real ) );
+      char digits[32];
+      std::snprintf( digits, sizeof( digits ), "r%.17g ", real );
+      text += digits;
+      break;
+    }
+    case Kind::bits:
+      text += 'b';
+      for( std::size_t i = 0; i < record.word; ++i ) {
+        const auto& packed = m_ring[ slot + 1 + i / ( 4 * sizeof( Record ) ) ];
+        auto byte = reinterpret_cast<const std::uint8_t*>( &packed )[ ( i / 4 ) % sizeof( Record ) ];
+        text += "01zx"[ ( byte >> ( 2 * ( i % 4 ) ) ) & 3 ];
+      }
+      text += ' ';
+      break;
+    case Kind::event:
+      text += '1';
+      break;
+  }
+  text += m_codes[ record.id ];
+  text += '\n';
+}
+
+//..............................................................................
+// Runs on a separate thread: after do_initialize() the only user of fp.
+// Polls the ring, sleeping briefly when it is empty so the simulation thread
+// never has to signal.
+void Vcd_trace_file::formatter()
+{
+  constexpr std::size_t   flush_size     = 64 * 1024;
+  constexpr std::uint64_t index_interval = 1024 * 1024; // bytes between index entries
+  auto file    = segment_name( 0 );
+  auto offset  = std::uint64_t{ 0 };
+  auto indexed = std::uint64_t{ 0 };
+  bool fresh   = true; // next time marker starts a segment
+  std::string text;
+  text.reserve( 2 * flush_size );
+  auto write = [this,&text,&offset]{
+    if( fp != nullptr ) std::fwrite( text.data(), 1, text.size(), fp );
+    offset += text.size();
+    written( text.size() );
+    text.clear();
+  };
+  auto tail = m_ring.tail();
+  for(;;) {
+    const auto head = m_ring.head();
+    if( tail == head ) {
+      if( m_done.load( std::memory_order_acquire ) ) {
+        if( tail == m_ring.head() ) break; // done and drained
+        continue;
+      }
+      if( not text.empty() ) write();
+      std::this_thread::sleep_for( std::chrono::microseconds{ 200 } );
+      continue;
+    }
+    while( tail != head ) {
+      const auto& record = m_ring[ tail ];
+      if( record.id == time_marker ) {
+        auto at = offset + text.size();
+        if( fresh or at - indexed >= index_interval ) {
+          index( file, record.word, at );
+          indexed = at;
+          fresh   = false;
+        }
+        text += '#';
+        text += std::to_string( record.word );
+        text += '\n';
+      }
+      else if( record.id == header_marker ) {
+        write();
+        std::string next;
+        {
+          std::lock_guard<std::mutex> lock{ m_mutex };
+          if( not m_files.empty() ) {
+            next = std::move( m_files.front() );
+            m_files.pop_front();
+          }
+        }
+        if( not next.empty() ) {
+          if( fp != nullptr ) std::fclose( fp );
+          fp = std::fopen( next.c_str(), "w" );
+          if( fp != nullptr ) std::setvbuf( fp, nullptr, _IOFBF, 256 * 1024 );
+          file    = next;
+          offset  = 0;
+          indexed = 0;
+          segment_opened();
+        }
+        format_header( text );
+        fresh = true;
+      }
+      else {
+        format_value( text, tail );
+      }
+      tail += 1 + record.extra;
+    }
+    m_ring.release( tail );
+    if( text.size() >= flush_size ) write();
+  }
+  write();
+}
+
+//------------------------------------------------------------------------------
+Delta_trace_file::Delta_trace_file( const char* name )
+: Trace_file{ name, "dlt" }
+{
+  delta_cycles( true );
+}
+
+Delta_trace_file::~Delta_trace_file()
+{
+  if( m_thread.joinable() ) {
+    m_done.store( true, std::memory_order_release );
+    m_thread.join();
+  }
+  // sc_trace_file_base closes fp
+}
+
+//..............................................................................
+void Delta_trace_file::do_initialize()
+{
+  if( fp != nullptr ) { // otherwise open_fp() already reported the problem
+    std::setvbuf( fp, nullptr, _IOFBF, 1024 * 1024 ); // buffered; never synced
+    m_thread = std::thread{ [this]{ writer(); } };
+  }
+  Trace_file::do_initialize();
+}
+
+//..............................................................................
+void Delta_trace_file::push( const Record* records, std::size_t count )
+{
+  if( m_thread.joinable() ) m_ring.push( records, count ); // else the file could not be opened
+}
+
+void Delta_trace_file::write_header()
+{
+  if( m_header.empty() ) { // never changed afterwards as the writer thread reads it
+    m_header = encode_header( Trace_codec::delta_magic, Trace_codec::delta_version, resolution_fs(), variables() );
+  }
+  Record record{ 0, 0, header_marker, 0 };
+  push( &record, 1 );
+}
+
+// Called once per (delta) cycle with changes; stamps the records that follow
+void Delta_trace_file::write_time( sc_dt::uint64 ticks )
+{
+  m_stamp.ticks = ticks;
+  m_stamp.delta = static_cast<std::uint32_t>( sc_delta_count() );
+}
+
+void Delta_trace_file::write_value( std::size_t id, std::uint64_t word )
+{
+  Record record{ m_stamp.ticks, m_stamp.delta, static_cast<std::uint32_t>( id ), word };
+  push( &record, 1 );
+}
+
+void Delta_trace_file::write_value( std::size_t id, const std::string& bits )
+{
+  const auto extra = ( bits.size() + Trace_codec::delta_digits - 1 ) / Trace_codec::delta_digits;
+  m_scratch.assign( 1 + extra, Record{ 0, 0, 0, 0 } );
+  m_scratch[0] = Record{ m_stamp.ticks, m_stamp.delta, static_cast<std::uint32_t>( id ), bits.size() };
+  pack_digits( bits, reinterpret_cast<std::uint8_t*>( m_scratch.data() + 1 ) );
+  push( m_scratch.data(), m_scratch.size() );
+}
+
+void Delta_trace_file::start_segment( const std::string& filename )
+{
+  std::lock_guard<std::mutex> lock{ m_mutex };
+  m_files.push_back( filename ); // opened at the header_marker that follows
+}
+
+//..............................................................................
+// Runs on a separate thread: after do_initialize() the only user of fp.
+// Records are copied out of the ring into large writes; continuation records
+// are skipped over when looking for markers since they hold raw digits.
+void Delta_trace_file::writer()
+{
+  constexpr std::size_t   flush_records  = 64 * 1024;
+  constexpr std::uint64_t index_interval = 1024 * 1024; // bytes between index entries
+  auto file    = segment_name( 0 );
+  auto offset  = std::uint64_t{ 0 };
+  auto indexed = std::uint64_t{ 0 };
+  bool fresh   = true; // next record starts a segment
+  std::vector<Record> out;
+  out.reserve( flush_records + 64 );
+  auto write = [this,&out,&offset]( const void* data, std::size_t bytes ) {
+    if( fp != nullptr ) std::fwrite( data, 1, bytes, fp );
+    offset += bytes;
+    written( bytes );
+  };
+  auto flush = [&]{
+    write( out.data(), out.size() * sizeof( Record ) );
+    out.clear();
+  };
+  auto tail = m_ring.tail();
+  std::size_t extra = 0; // continuation records still to copy
+  for(;;) {
+    const auto head = m_ring.head();
+    if( tail == head ) {
+      if( m_done.load( std::memory_order_acquire ) ) {
+        if( tail == m_ring.head() ) break; // done and drained
+        continue;
+      }
+      if( not out.empty() ) flush();
+      std::this_thread::sleep_for( std::chrono::microseconds{ 200 } );
+      continue;
+    }
+    for( ; tail != head; ++tail ) {
+      const auto& record = m_ring[ tail ];
+      if( extra != 0 ) {
+        out.push_back( record );
+        --extra;
+        continue;
+      }
+      if( record.id == header_marker ) {
+        flush();
+        std::string next;
+        {
+          std::lock_guard<std::mutex> lock{ m_mutex };
+          if( not m_files.empty() ) {
+            next = std::move( m_files.front() );
+            m_files.pop_front();
+          }
+        }
+        if( not next.empty() ) {
+          if( fp != nullptr ) std::fclose( fp );
+          fp = std::fopen( next.c_str(), "wb" );
+          if( fp != nullptr ) std::setvbuf( fp, nullptr, _IOFBF, 1024 * 1024 );
+          file    = next;
+          offset  = 0;
+          segment_opened();
+        }
+        write( m_header.data(), m_header.size() );
+        indexed = offset;
+        fresh   = true;
+        continue;
+      }
+      auto at = offset + out.size() * sizeof( Record );
+      if( fresh or at - indexed >= index_interval ) {
+        index( file, record.ticks, at );
+        indexed = at;
+        fresh   = false;
+      }
+      if( variables()[ record.id ].kind == Kind::bits ) {
+        extra = ( record.value + Trace_codec::delta_digits - 1 ) / Trace_codec::delta_digits;
+      }
+      out.push_back( record );
+      if( out.size() >= flush_records and extra == 0 ) flush();
+    }
+    m_ring.release( tail );
+  }
+  flush();
+}
+
+}//endnamespace Doulos
+
+// TAGS: Doulos, SystemC, trace, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
@@ -0,0 +1,285 @@
+#pragma once
+
+// Alternative waveform writers that plug into the standard sc_trace() API.
+//
+// Trace_file samples every registered object once per (delta) cycle and
+// forwards only the values that changed to a concrete writer. Bin_trace_file
+// is such a writer: it emits a compact binary stream that is compressed in
+// blocks on a background thread, which keeps the simulation thread free of
+// formatting and I/O work. Use trace2vcd to convert the result for viewing.
+// Vcd_trace_file writes ordinary VCD the same way: the simulation thread only
+// appends fixed-size change records to a lock-free single-producer ring and a
+// background thread turns them into text. Delta_trace_file also samples every
+// delta cycle and spills fixed-size records tagged with the delta count to
+// disk, so that glitches within a time step can be examined (see trace2vcd).
+//
+// Output may be rolled into self-contained segments (each begins with a header
+// and a snapshot of every value) by simulated time and/or size. A side index,
+// NAME.idx, lists "file time_fs byte_offset" for every block so tools can
+// seek to a time window without reading everything before it.
+//
+// See trace_codec.hpp for the file layout and ABOUT_Debug.md for usage.
+
+#include <systemc>
+#include <sysc/tracing/sc_trace_file_base.h>
+#include "trace_codec.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Doulos {
+
+//------------------------------------------------------------------------------
+// Lock-free ring of fixed-size records with one producer (the simulation
+// thread) and one consumer (a writer thread).
+template<typename Record, std::size_t Size>
+class Spsc_ring
+{
+public:
+  static_assert( ( Size & ( Size - 1 ) ) == 0, "Size must be a power of two" );
+  Spsc_ring() : m_slots( Size ) {}
+
+  // Producer: copies and publishes records; waits only if the consumer is a
+  // whole ring behind.
+  void push( const Record* records, std::size_t count ) {
+    const auto head = m_head.load( std::memory_order_relaxed );
+    while( head + count - m_tail.load( std::memory_order_acquire ) > Size ) std::this_thread::yield();
+    for( std::size_t k = 0; k < count; ++k ) m_slots[ ( head + k ) & ( Size - 1 ) ] = records[k];
+    m_head.store( head + count, std::memory_order_release );
+  }
+
+  // Consumer: slots [tail(), head()) may be read until release() frees them
+  std::size_t head() const { return m_head.load( std::memory_order_acquire ); }
+  std::size_t tail() const { return m_tail.load( std::memory_order_relaxed ); }
+  const Record& operator[]( std::size_t slot ) const { return m_slots[ slot & ( Size - 1 ) ]; }
+  void release( std::size_t tail ) { m_tail.store( tail, std::memory_order_release ); }
+
+private:
+  std::vector<Record>                  m_slots;
+  alignas(64) std::atomic<std::size_t> m_head{ 0 }; // next slot to write
+  alignas(64) std::atomic<std::size_t> m_tail{ 0 }; // next slot to read
+};
+
+//------------------------------------------------------------------------------
+class Trace_file : public sc_core::sc_trace_file_base
+{
+public:
+  using Kind = Trace_codec::Kind;
+  struct Variable {
+    std::string name;
+    Kind        kind;
+    int         width;
+  };
+  struct Sample; // see trace_file.cpp
+
+  ~Trace_file() override;
+
+  // Overrides of sc_trace_file (override omitted because the set of
+  // overloads differs slightly between SystemC versions)
+  void trace( const sc_core::sc_event&  object, const std::string& name );
+  void trace( const sc_core::sc_time&   object, const std::string& name );
+  void trace( const bool&               object, const std::string& name );
+  void trace( const sc_dt::sc_bit&      object, const std::string& name );
+  void trace( const sc_dt::sc_logic&    object, const std::string& name );
+  void trace( const unsigned char&      object, const std::string& name, int width );
+  void trace( const unsigned short&     object, const std::string& name, int width );
+  void trace( const unsigned int&       object, const std::string& name, int width );
+  void trace( const unsigned long&      object, const std::string& name, int width );
+  void trace( const char&               object, const std::string& name, int width );
+  void trace( const short&              object, const std::string& name, int width );
+  void trace( const int&                object, const std::string& name, int width );
+  void trace( const long&               object, const std::string& name, int width );
+  void trace( const sc_dt::int64&       object, const std::string& name, int width );
+  void trace( const sc_dt::uint64&      object, const std::string& name, int width );
+  void trace( const float&              object, const std::string& name );
+  void trace( const double&             object, const std::string& name );
+  void trace( const sc_dt::sc_int_base&    object, const std::string& name );
+  void trace( const sc_dt::sc_uint_base&   object, const std::string& name );
+  void trace( const sc_dt::sc_signed&      object, const std::string& name );
+  void trace( const sc_dt::sc_unsigned&    object, const std::string& name );
+  void trace( const sc_dt::sc_fxval&       object, const std::string& name );
+  void trace( const sc_dt::sc_fxval_fast&  object, const std::string& name );
+  void trace( const sc_dt::sc_fxnum&       object, const std::string& name );
+  void trace( const sc_dt::sc_fxnum_fast&  object, const std::string& name );
+  void trace( const sc_dt::sc_bv_base&     object, const std::string& name );
+  void trace( const sc_dt::sc_lv_base&     object, const std::string& name );
+  void trace( const unsigned int&       object, const std::string& name, const char** enum_literals );
+  void write_comment( const std::string& comment ) override;
+
+  // Start a new segment every period and/or when a segment reaches max_bytes
+  // (zero disables either). Segments after the first are named NAME-0001.EXT...
+  void set_segments( const sc_core::sc_time& period, std::uint64_t max_bytes = 0 );
+  bool segmenting() const { return m_segment_period != sc_core::SC_ZERO_TIME or m_segment_limit != 0; }
+
+protected:
+  Trace_file( const char* name, const char* extension );
+  const std::vector<Variable>& variables() const { return m_variables; }
+  std::uint64_t resolution_fs() const { return m_resolution_fs; }
+  std::string segment_name( std::size_t segment ) const;
+  void index( const std::string& file, sc_dt::uint64 ticks, std::uint64_t offset ); // appends to NAME.idx
+
+  // Concrete writers
+  virtual void write_header() = 0; // fp is open; variables() are final
+  virtual void write_time( sc_dt::uint64 ticks ) = 0; // kernel resolution units
+  virtual void write_value( std::size_t id, std::uint64_t word ) = 0;
+  virtual void write_value( std::size_t id, const std::string& bits ) = 0;
+  virtual void start_segment( const std::string& filename ) = 0; // finish current output, continue in filename
+
+  // Writer thread bookkeeping used to decide when a segment is full
+  void written( std::uint64_t bytes ) { m_written += bytes; }
+  void segment_opened();
+
+  void do_initialize() override;
+  void cycle( bool delta_cycle ) override;
+
+private:
+  template<typename Sampler>
+  void add( const std::string& name, Kind kind, int width, Sampler&& sampler );
+  void emit( std::size_t id );
+  void snapshot( bool initial ); // time plus every value
+  bool segment_due();
+  std::uint64_t segment_bytes(); // zero until the writer has opened the latest segment
+
+  std::vector<Variable>                m_variables;
+  std::vector<std::unique_ptr<Sample>> m_samples;
+  std::string                          m_name;
+  std::string                          m_extension;
+  std::uint64_t                        m_resolution_fs{ 1 };
+  sc_core::sc_time                     m_segment_period{ sc_core::SC_ZERO_TIME };
+  sc_core::sc_time                     m_segment_start{ sc_core::SC_ZERO_TIME };
+  std::uint64_t                        m_segment_limit{ 0 };
+  std::size_t                          m_segment{ 0 };
+  std::FILE*                           m_index{ nullptr };
+  std::atomic<std::size_t>             m_segments_opened{ 0 };
+  std::atomic<std::uint64_t>           m_written{ 0 };        // bytes written to all segments
+  std::atomic<std::uint64_t>           m_segment_origin{ 0 }; // m_written when the segment opened
+};
+
+//------------------------------------------------------------------------------
+class Bin_trace_file final : public Trace_file
+{
+public:
+  explicit Bin_trace_file( const char* name );
+  ~Bin_trace_file() override;
+
+protected:
+  void do_initialize() override; // starts the compressor thread
+  void write_header() override;
+  void write_time( sc_dt::uint64 ticks ) override;
+  void write_value( std::size_t id, std::uint64_t word ) override;
+  void write_value( std::size_t id, const std::string& bits ) override;
+  void start_segment( const std::string& filename ) override;
+
+private:
+  using Block = std::vector<std::uint8_t>;
+  struct Chunk {
+    Block         data;
+    sc_dt::uint64 ticks{ 0 };  // block: time at start of block
+    bool          header{ false };
+    std::string   file{};      // header: start of a new segment file if not empty
+  };
+  void start_block();
+  void flush_block();
+  void push( Chunk&& chunk );
+  void compressor(); // background thread
+
+  Block                      m_block;
+  std::vector<std::uint64_t> m_previous; // per-variable, for delta encoding
+  sc_dt::uint64              m_ticks{ 0 };
+  sc_dt::uint64              m_last_ticks{ 0 };
+  sc_dt::uint64              m_block_ticks{ 0 };
+  std::string                m_next_file{};
+  std::thread                m_thread;
+  std::mutex                 m_mutex;
+  std::condition_variable    m_ready;
+  std::deque<Chunk>          m_queue;
+  bool                       m_done{ false };
+};
+
+//------------------------------------------------------------------------------
+class Vcd_trace_file final : public Trace_file
+{
+public:
+  explicit Vcd_trace_file( const char* name );
+  ~Vcd_trace_file() override; // drains the ring and joins the formatter
+
+protected:
+  void do_initialize() override; // starts the formatter thread
+  void write_header() override;
+  void write_time( sc_dt::uint64 ticks ) override;
+  void write_value( std::size_t id, std::uint64_t word ) override;
+  void write_value( std::size_t id, const std::string& bits ) override;
+  void start_segment( const std::string& filename ) override;
+
+private:
+  // One ring slot. Kind::bits values are followed by `extra` slots of packed
+  // 2-bit digits (see Trace_codec::put_bits).
+  struct Record {
+    std::uint32_t id;    // variable, or one of the markers below
+    std::uint32_t extra; // continuation slots that follow
+    std::uint64_t word;  // value, or ticks for time_marker
+  };
+  static constexpr std::uint32_t time_marker   = UINT32_MAX;
+  static constexpr std::uint32_t header_marker = UINT32_MAX - 1; // also switches to a queued segment
+
+  void push( const Record* records, std::size_t count );
+  void formatter(); // background thread
+  void format_header( std::string& text ) const;
+  void format_value( std::string& text, std::size_t slot ) const; // slot holds a value record
+
+  Spsc_ring<Record, 1u << 16>           m_ring;
+  std::atomic<bool>                     m_done{ false };
+  std::vector<std::string>              m_codes;     // VCD identifier per variable
+  std::vector<Record>                   m_scratch;   // bits record under construction
+  std::mutex                            m_mutex;     // guards m_files
+  std::deque<std::string>               m_files;     // segments waiting to be opened
+  std::thread                           m_thread;
+};
+
+//------------------------------------------------------------------------------
+class Delta_trace_file final : public Trace_file
+{
+public:
+  explicit Delta_trace_file( const char* name ); // enables delta cycle tracing
+  ~Delta_trace_file() override; // drains the ring and joins the writer
+
+protected:
+  void do_initialize() override; // starts the writer thread
+  void write_header() override;
+  void write_time( sc_dt::uint64 ticks ) override;
+  void write_value( std::size_t id, std::uint64_t word ) override;
+  void write_value( std::size_t id, const std::string& bits ) override;
+  void start_segment( const std::string& filename ) override;
+
+private:
+  using Record = Trace_codec::Delta_record;
+  static constexpr std::uint32_t header_marker = UINT32_MAX; // also switches to a queued segment
+
+  void push( const Record* records, std::size_t count );
+  void writer(); // background thread
+
+  Spsc_ring<Record, 1u << 16> m_ring;
+  std::atomic<bool>           m_done{ false };
+  std::vector<std::uint8_t>   m_header;   // same for every segment
+  Record                      m_stamp{};  // time and delta of the current cycle
+  std::vector<Record>         m_scratch;  // bits record under construction
+  std::mutex                  m_mutex;    // guards m_files
+  std::deque<std::string>     m_files;    // segments waiting to be opened
+  std::thread                 m_thread;
+};
+
+}//endnamespace Doulos
+
+// TAGS: Doulos, SystemC, trace, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
@@ -0,0 +1,108 @@
+#include "tx_recorder.hpp"
+#include "trace_codec.hpp"
+#include "report.hpp"
+using namespace sc_core;
+using namespace std::literals;
+
+namespace {
+constexpr const char* msg_type = "/Doulos/Debug/Tx_recorder";
+}
+
+namespace Doulos {
+
+using namespace Trace_codec;
+
+//------------------------------------------------------------------------------
+Tx_recorder::Tx_recorder( const std::string& filename )
+: m_filename{ filename }
+, m_fp{ std::fopen( filename.c_str(), "wb" ) }
+{
+  if( m_fp == nullptr ) {
+    REPORT_ERROR( "Unable to create transaction recording "s + filename );
+    return;
+  }
+  std::setvbuf( m_fp, nullptr, _IOFBF, 4 * block_size );
+  m_block.reserve( block_size + 64 );
+}
+
+Tx_recorder::~Tx_recorder()
+{
+  flush();
+  if( m_fp != nullptr ) std::fclose( m_fp );
+}
+
+//..............................................................................
+std::size_t Tx_recorder::stream( const std::string& name )
+{
+  auto [it, added] = m_streams.emplace( name, m_streams.size() );
+  if( added ) {
+    m_block.push_back( tx_stream );
+    put_varint( m_block, name.size() );
+    m_block.insert( m_block.end(), name.begin(), name.end() );
+  }
+  return it->second;
+}
+
+//..............................................................................
+// Time relative to the previous record of the block
+void Tx_recorder::stamp()
+{
+  auto ticks = sc_time_stamp().value();
+  put_varint( m_block, ticks - m_last_ticks );
+  m_last_ticks = ticks;
+}
+
+void Tx_recorder::begin( std::size_t stream, std::uint64_t id, std::int64_t payload )
+{
+  m_block.push_back( tx_begin );
+  put_varint( m_block, stream );
+  put_varint( m_block, id );
+  stamp();
+  put_varint( m_block, zigzag( payload ) );
+  ++m_count;
+  if( m_block.size() >= block_size ) flush();
+}
+
+void Tx_recorder::end( std::size_t stream, std::uint64_t id )
+{
+  m_block.push_back( tx_end );
+  put_varint( m_block, stream );
+  put_varint( m_block, id );
+  stamp();
+  if( m_block.size() >= block_size ) flush();
+}
+
+//..............................................................................
+void Tx_recorder::flush()
+{
+  if( m_fp == nullptr ) { // nowhere to write, so don't accumulate
+    m_block.clear();
+    return;
+  }
+  if( not m_header ) {
+    std::vector<std::uint8_t> header{ tx_magic, tx_magic + magic_size };
+    put_varint( header, tx_version );
+    put_varint( header, static_cast<std::uint64_t>( sc_get_time_resolution().to_seconds() * 1e15 + 0.5 ) );
+    std::fwrite( header.data(), 1, header.size(), m_fp );
+    m_header = true;
+  }
+  if( m_block.empty() ) return;
+  compress( m_block.data(), m_block.size(), m_compressed );
+  const auto& data = ( m_compressed.size() < m_block.size() ) ? m_compressed : m_block;
+  std::vector<std::uint8_t> sizes;
+  put_varint( sizes, m_block.size() );
+  put_varint( sizes, data.size() );
+  std::fwrite( sizes.data(), 1, sizes.size(), m_fp );
+  std::fwrite( data.data(), 1, data.size(), m_fp );
+  m_block.clear();
+  m_last_ticks = 0;
+}
+
+}//endnamespace Doulos
+
+// TAGS: Doulos, SystemC, transaction, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
@@ -0,0 +1,71 @@
+#pragma once
+
+// Records the begin and end of transactions (e.g., fifo transfers) into a
+// compact binary stream for offline analysis; see txr2csv.cpp.
+//
+// File layout (integers are varints, see trace_codec.hpp):
+//
+//   "DBGTXREC" version resolution_fs
+//   blocks { raw_size stored_size data }... (LZ compressed as for traces)
+//
+// Decompressed blocks hold records:
+//
+//   tx_stream name_length name               declares the next stream number
+//   tx_begin  stream id ticks_delta payload  payload is zigzag encoded
+//   tx_end    stream id ticks_delta
+//
+// Time deltas restart from zero at the start of each block.
+//
+// Example:
+//
+//   auto stream = recorder.stream( fifo.name() );
+//   recorder.begin( stream, tx.id(), tx.data() ); // producer
+//   recorder.end( stream, rx.id() );              // consumer
+
+#include <systemc>
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace Doulos {
+
+class Tx_recorder
+{
+public:
+  explicit Tx_recorder( const std::string& filename ); // reports an error if unable to open
+  ~Tx_recorder(); // flushes and closes
+  Tx_recorder( const Tx_recorder& ) = delete;
+  Tx_recorder& operator=( const Tx_recorder& ) = delete;
+
+  [[nodiscard]] const std::string& filename() const { return m_filename; }
+  [[nodiscard]] bool is_open() const { return m_fp != nullptr; }
+  [[nodiscard]] std::uint64_t count() const { return m_count; } // transactions begun
+
+  std::size_t stream( const std::string& name ); // same name returns the same stream
+  void begin( std::size_t stream, std::uint64_t id, std::int64_t payload = 0 ); // at sc_time_stamp()
+  void end( std::size_t stream, std::uint64_t id );
+
+private:
+  void stamp();
+  void flush();
+
+  std::string                       m_filename;
+  std::FILE*                        m_fp{ nullptr };
+  std::vector<std::uint8_t>         m_block;
+  std::vector<std::uint8_t>         m_compressed;
+  std::map<std::string,std::size_t> m_streams;
+  sc_dt::uint64                     m_last_ticks{ 0 };
+  std::uint64_t                     m_count{ 0 };
+  bool                              m_header{ false }; // written lazily so resolution is final
+};
+
+}//endnamespace Doulos
+
+// TAGS: Doulos, SystemC, transaction, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
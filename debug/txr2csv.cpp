@@ -0,0 +1,164 @@
+// Convert a transaction recording (--record) into CSV and summarize it.
+//
+// Usage: txr2csv INPUT.txr [OUTPUT.csv]
+//
+// Each CSV row is one transaction: stream,id,begin_fs,end_fs,payload. A
+// transaction that never ended has an empty end_fs. Per stream totals and
+// latencies (end - begin) are printed to stdout.
+//
+// Does not depend on SystemC.
+
+#include "trace_codec.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace Doulos::Trace_codec;
+using namespace std::literals;
+
+namespace {
+
+struct Stream {
+  std::string   name;
+  std::uint64_t begun{ 0 };
+  std::uint64_t ended{ 0 };
+  std::uint64_t latency_min{ UINT64_MAX };
+  std::uint64_t latency_max{ 0 };
+  double        latency_sum{ 0 };
+  std::unordered_map<std::uint64_t, std::pair<std::uint64_t, std::int64_t>> open; // id -> begin_fs, payload
+};
+
+int fail( const std::string& message )
+{
+  std::cerr << "Error: " << message << '\n';
+  return 1;
+}
+
+}//endnamespace
+
+int main( int argc, char* argv[] )
+{
+  if( argc < 2 or argc > 3 ) {
+    std::cerr << "Usage: txr2csv INPUT.txr [OUTPUT.csv]\n";
+    return 1;
+  }
+  auto input_name  = std::string{ argv[1] };
+  auto output_name = ( argc == 3 ) ? std::string{ argv[2] } : input_name.substr( 0, input_name.rfind( '.' ) ) + ".csv"s;
+
+  std::ifstream input{ input_name, std::ios::binary };
+  if( not input ) return fail( "Unable to open "s + input_name );
+  const std::vector<std::uint8_t> file{ std::istreambuf_iterator<char>{ input }, std::istreambuf_iterator<char>{} };
+  const auto* in = file.data();
+  const auto  n  = file.size();
+
+  //----------------------------------------------------------------------------
+  // Header
+  //............................................................................
+  if( n < magic_size or std::string( file.begin(), file.begin() + magic_size ) != tx_magic ) {
+    return fail( input_name + " is not a transaction recording"s );
+  }
+  std::size_t pos = magic_size;
+  std::uint64_t file_version, resolution_fs;
+  if( not get_varint( in, n, pos, file_version ) or file_version != tx_version ) {
+    return fail( "Unsupported version in "s + input_name );
+  }
+  if( not get_varint( in, n, pos, resolution_fs ) ) return fail( "Truncated header in "s + input_name );
+
+  std::ofstream output{ output_name };
+  if( not output ) return fail( "Unable to create "s + output_name );
+  output << "stream,id,begin_fs,end_fs,payload\n";
+
+  //----------------------------------------------------------------------------
+  // Blocks
+  //............................................................................
+  std::vector<Stream> streams;
+  std::vector<std::uint8_t> raw;
+  while( pos < n ) {
+    std::uint64_t raw_size, stored_size;
+    if( not get_varint( in, n, pos, raw_size ) or not get_varint( in, n, pos, stored_size ) or pos + stored_size > n ) {
+      return fail( "Truncated block in "s + input_name );
+    }
+    raw.clear();
+    if( stored_size == raw_size ) raw.assign( in + pos, in + pos + stored_size );
+    else if( not decompress( in + pos, stored_size, raw ) or raw.size() != raw_size ) {
+      return fail( "Corrupt block in "s + input_name );
+    }
+    pos += stored_size;
+
+    std::size_t at = 0;
+    const auto* data = raw.data();
+    std::uint64_t ticks = 0; // deltas restart each block
+    while( at < raw.size() ) {
+      auto kind = data[at++];
+      std::uint64_t stream, id, delta, payload, length;
+      if( kind == tx_stream ) {
+        if( not get_varint( data, raw.size(), at, length ) or at + length > raw.size() ) {
+          return fail( "Corrupt record in "s + input_name );
+        }
+        streams.emplace_back();
+        streams.back().name.assign( reinterpret_cast<const char*>( data + at ), length );
+        at += length;
+        continue;
+      }
+      if( not get_varint( data, raw.size(), at, stream ) or not get_varint( data, raw.size(), at, id )
+       or not get_varint( data, raw.size(), at, delta ) or stream >= streams.size() ) {
+        return fail( "Corrupt record in "s + input_name );
+      }
+      ticks += delta;
+      auto& s = streams[stream];
+      auto time_fs = ticks * resolution_fs;
+      if( kind == tx_begin ) {
+        if( not get_varint( data, raw.size(), at, payload ) ) return fail( "Corrupt record in "s + input_name );
+        s.open[id] = { time_fs, unzigzag( payload ) };
+        ++s.begun;
+      }
+      else if( kind == tx_end ) {
+        auto found = s.open.find( id );
+        if( found == s.open.end() ) continue; // began before recording started
+        auto [begin_fs, value] = found->second;
+        s.open.erase( found );
+        output << s.name << ',' << id << ',' << begin_fs << ',' << time_fs << ',' << value << '\n';
+        auto latency = time_fs - begin_fs;
+        s.latency_min  = std::min( s.latency_min, latency );
+        s.latency_max  = std::max( s.latency_max, latency );
+        s.latency_sum += static_cast<double>( latency );
+        ++s.ended;
+      }
+      else {
+        return fail( "Unknown record in "s + input_name );
+      }
+    }
+  }
+
+  //----------------------------------------------------------------------------
+  // Summary
+  //............................................................................
+  std::uint64_t total = 0;
+  for( auto& s : streams ) {
+    for( const auto& [id, begun] : s.open ) {
+      output << s.name << ',' << id << ',' << begun.first << ",," << begun.second << '\n';
+    }
+    std::cout << s.name << ": " << s.begun << " begun, " << s.ended << " ended";
+    if( s.ended != 0 ) {
+      std::cout << ", latency min/avg/max " << s.latency_min << '/'
+                << static_cast<std::uint64_t>( s.latency_sum / static_cast<double>( s.ended ) ) << '/'
+                << s.latency_max << " fs";
+    }
+    std::cout << '\n';
+    total += s.begun;
+  }
+  std::cout << "Converted " << total << " transactions of " << streams.size()
+            << " streams from " << input_name << " to " << output_name << '\n';
+  return 0;
+}
+
+// TAGS: Doulos, SystemC, transaction, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
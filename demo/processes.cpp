@@ -1,5 +1,6 @@
 #include "processes.hpp"
 #include "objection.hpp"
+#include <chrono>
 #include <random>
 using namespace sc_core;
 using namespace std::literals;
@@ -40,13 +41,12 @@ void Processes_module::start_of_simulation()
   if (t > 0 ) {
     nSamples = t;
   }
-  if( Debug::tracing() ) {
-    sc_trace( Debug::trace_file(), m_level, "m_level" );
-  }
+  Debug::trace( m_level, "m_level", this );
   info.executed( __func__, this );
 }
 
 void Processes_module::end_of_simulation() {
+  if( m_host.joinable() ) m_host.join();
   info.executed( __func__, this );
 }
 
@@ -54,6 +54,7 @@ void Processes_module::end_of_simulation() {
 // Processes
 //------------------------------------------------------------------------------
 void Processes_module::p1_thread() {
+  if( Debug::parsed( "nHostMs" ) ) host_work( Debug::get_count( "nHostMs" ) );
   random_delays( __func__, nSamples );
 }
 
@@ -104,6 +105,17 @@ void Processes_module::random_delays( const string& threadName, size_t loopCount
   }
 }
 
+// Simulates work handed to a host thread (e.g., a software model running
+// natively). The objection keeps the simulation alive until it is done.
+void Processes_module::host_work( size_t milliseconds )
+{
+  m_host_objection.raise();
+  m_host = std::thread{ [this,milliseconds]{
+    std::this_thread::sleep_for( std::chrono::milliseconds( milliseconds ) );
+    m_host_objection.drop(); // from outside SystemC
+  } };
+}
+
 volatile int bug = 0;
 
 void Processes_module::computation( const string& threadName ) {
@@ -5,7 +5,9 @@
 #include <random>
 #include <map>
 #include <cstdint>
+#include <thread>
 #include "debug.hpp"
+#include "objection.hpp"
 
 struct Processes_module : sc_core::sc_module
 {
@@ -33,6 +35,7 @@ private:
   void computation( const std::string& threadName );
   sc_core::sc_time random_time();
   void random_delays( const std::string& threadName, size_t loopCount );
+  void host_work( size_t milliseconds ); // see --nHostMs
 
   //----------------------------------------------------------------------------
   // Data
@@ -41,4 +44,6 @@ private:
   std::mt19937                  random_generator;
   std::discrete_distribution<>  time_distribution;
   size_t nSamples{ 1'000 };
+  Objection::Async              m_host_objection{ "host_work", this }; //< raised by m_host
+  std::thread                   m_host{};
 };
@@ -0,0 +1,70 @@
+#pragma once
+
+/** @brief Burst transfers over the standard sc_fifo interfaces
+ *
+ * A process that reads or writes one item per blocking call pays for (at
+ * least) one context switch per item. These helpers move many items per
+ * activation instead, using only the sc_fifo_in_if/sc_fifo_out_if methods,
+ * so they work with any sc_fifo and through existing sc_export/sc_port
+ * bindings:
+ *
+ * - Doulos::write_n( fifo, data, count ) writes all items, blocking only
+ *   while the fifo is full.
+ * - Doulos::read_n( fifo, data, count ) blocks only while the fifo is empty,
+ *   then reads whatever is available, up to count, and returns how many.
+ *
+ * Doulos::Burst_fifo_in<T> and Burst_fifo_out<T> are drop-in replacements for
+ * sc_fifo_in<T> and sc_fifo_out<T> (they bind to the same interfaces) that add
+ * read_n() and write_n() members.
+ *
+ *   Doulos::Burst_fifo_in<Transaction> data_in{"data_in"}; // was sc_fifo_in
+ *   ...
+ *   auto n = data_in.read_n( buffer.data(), buffer.size() );
+ */
+
+#include <systemc>
+#include <cstddef>
+
+namespace Doulos {
+
+template<typename T>
+std::size_t read_n( sc_core::sc_fifo_in_if<T>& fifo, T* data, std::size_t count )
+{
+  if( count == 0 ) return 0;
+  while( fifo.num_available() == 0 ) sc_core::wait( fifo.data_written_event() );
+  auto n = std::size_t{ 0 };
+  while( n < count and fifo.nb_read( data[n] ) ) ++n;
+  return n;
+}
+
+template<typename T>
+void write_n( sc_core::sc_fifo_out_if<T>& fifo, const T* data, std::size_t count )
+{
+  for( auto n = std::size_t{ 0 }; n < count; ) {
+    while( fifo.num_free() == 0 ) sc_core::wait( fifo.data_read_event() );
+    while( n < count and fifo.nb_write( data[n] ) ) ++n;
+  }
+}
+
+template<typename T>
+struct Burst_fifo_in : sc_core::sc_fifo_in<T>
+{
+  using sc_core::sc_fifo_in<T>::sc_fifo_in;
+  std::size_t read_n( T* data, std::size_t count ) { return Doulos::read_n( *this->operator->(), data, count ); }
+};
+
+template<typename T>
+struct Burst_fifo_out : sc_core::sc_fifo_out<T>
+{
+  using sc_core::sc_fifo_out<T>::sc_fifo_out;
+  void write_n( const T* data, std::size_t count ) { Doulos::write_n( *this->operator->(), data, count ); }
+};
+
+}//endnamespace Doulos
+
+// TAGS: Doulos, SystemC, performance, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
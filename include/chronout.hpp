@@ -3,17 +3,23 @@
 #include <string>
 #include <chrono>
 #include <cmath>
+#include <cstdio>
 #include <ratio>
+#include <charconv>
 /** @brief Provide to_string( time )
  *
- * Two syntax's:
+ * Three syntax's:
  * 1. to_string( duration, digits=3 ), where digits specifies precision
  * 2. to_string( duration, units, digits=3), where units: 1h, 1min, 1s, 1ms, etc.
+ * 3. to_string( duration, Chronout::hms, digits=3 ), which includes hours &
+ *    minutes as needed (e.g. "1h2min5.5s")
+ *
+ * Each has a format( first, last, ... ) counterpart that writes into a caller
+ * supplied buffer without allocating and returns one past the last character
+ * written (or first if the buffer is too small).
  *
  * Also includes a special `long double Round<T>( T, digits )` that
  * may be of interest to some.
- *
- * TODO: to_string( duration, hms, units ), includes hours & minutes as needed
  */
 template<typename T=long double>
 constexpr long double Round( T value, int digits=3 )
@@ -27,44 +33,122 @@ class Chronout {
 public:
   using ns_t = std::chrono::nanoseconds;
   using double_ns_t = std::chrono::duration<long double,std::nano>;
+  struct hms_t { explicit hms_t() = default; };
+  static constexpr hms_t hms{};
+  static constexpr std::size_t max_size = 64; // enough for any of the formats below
 
   // Use the largest time unit possible (e.g. 100s => "1.667min")
-  static std::string to_string( double_ns_t t, int digits = 3 )
+  static char* format( char* first, char* last, double_ns_t t, int digits = 3 )
   {
     using namespace std::chrono_literals;
-    std::string suffix, result;
-    // Round to the nearest appropriate time unit
-    if      ( t >= 1.0h   ) { result = std::to_string( Round( t/1.0h  , digits )); suffix = "h";  }
-    else if ( t >= 1.0min ) { result = std::to_string( Round( t/1.0min, digits )); suffix = "min";}
-    else if ( t >= 1.0s   ) { result = std::to_string( Round( t/1.0s  , digits )); suffix = "s";  }
-    else if ( t >= 1.0ms  ) { result = std::to_string( Round( t/1.0ms , digits )); suffix = "ms"; }
-    else if ( t >= 1.0us  ) { result = std::to_string( Round( t/1.0us , digits )); suffix = "us"; }
-    else                    { result = std::to_string( Round( t/1.0ns , digits )); suffix = "ns"; }
-    // Remove trailing zeroes after the decimal point except if the entire fraction is zero
-    auto pos = result.find_last_of(".123456789");
-    if ( pos != std::string::npos and pos < result.size() ) result.erase( pos+1 );
-    if ( result.back() == '.' ) result += '0';
-    return result + suffix;
+    if      ( t >= 1.0h   ) return done( first, number( first, last, t/1.0h, digits, "h" ) );
+    else if ( t >= 1.0min ) return done( first, number( first, last, t/1.0min, digits, "min" ) );
+    else if ( t >= 1.0s   ) return done( first, number( first, last, t/1.0s, digits, "s" ) );
+    else if ( t >= 1.0ms  ) return done( first, number( first, last, t/1.0ms, digits, "ms" ) );
+    else if ( t >= 1.0us  ) return done( first, number( first, last, t/1.0us, digits, "us" ) );
+    else                    return done( first, number( first, last, t/1.0ns, digits, "ns" ) );
   }
 
   // Specify specific base time units desired (e.g. 1min in ms => "60000.0ms")
-  static std::string to_string( double_ns_t t, ns_t units, int digits = 3 )
+  static char* format( char* first, char* last, double_ns_t t, ns_t units, int digits = 3 )
+  {
+    using namespace std::chrono_literals;
+    if      ( units == 24h  ) return done( first, number( first, last, t/24.0h, digits, "d" ) );
+    else if ( units == 1h   ) return done( first, number( first, last, t/1.0h, digits, "h" ) );
+    else if ( units == 1min ) return done( first, number( first, last, t/1.0min, digits, "min" ) );
+    else if ( units == 1s   ) return done( first, number( first, last, t/1.0s, digits, "s" ) );
+    else if ( units == 1ms  ) return done( first, number( first, last, t/1.0ms, digits, "ms" ) );
+    else if ( units == 1us  ) return done( first, number( first, last, t/1.0us, digits, "us" ) );
+    else                      return done( first, number( first, last, t/1.0ns, digits, "ns" ) );
+  }
+
+  // Hours, minutes and seconds as needed (e.g. 3725.5s => "1h2min5.5s");
+  // durations under a minute are formatted as above
+  static char* format( char* first, char* last, double_ns_t t, hms_t, int digits = 3 )
   {
     using namespace std::chrono_literals;
-    std::string suffix, result;
-    // Round to the specified time unit
-    if      ( units == 24h  ) { result = std::to_string( Round( t/24.0h , digits )); suffix = "d";  }
-    else if ( units == 1h   ) { result = std::to_string( Round( t/1.0h  , digits )); suffix = "h";  }
-    else if ( units == 1min ) { result = std::to_string( Round( t/1.0min, digits )); suffix = "min";}
-    else if ( units == 1s   ) { result = std::to_string( Round( t/1.0s  , digits )); suffix = "s";  }
-    else if ( units == 1ms  ) { result = std::to_string( Round( t/1.0ms , digits )); suffix = "ms"; }
-    else if ( units == 1us  ) { result = std::to_string( Round( t/1.0us , digits )); suffix = "us"; }
-    else                      { result = std::to_string( Round( t/1.0ns , digits )); suffix = "ns"; }
-    // Remove trailing zeroes after the decimal point except if the entire fraction is zero
-    auto pos = result.find_last_of(".123456789");
-    if ( pos != std::string::npos and pos < result.size() ) result.erase( pos+1 );
-    if ( result.back() == '.' ) result += '0';
-    return result + suffix;
+    if ( t < 1.0min ) return format( first, last, t, digits );
+    auto seconds = static_cast<long double>( Round( t/1.0s, digits ) );
+    auto hours   = static_cast<unsigned long long>( seconds / 3600 );
+    seconds     -= 3600.0L * hours;
+    auto minutes = static_cast<unsigned long long>( seconds / 60 );
+    seconds     -= 60.0L * minutes;
+    auto next = first;
+    if ( hours   != 0 ) next = integer( next, last, hours,   "h"   );
+    if ( minutes != 0 ) next = integer( next, last, minutes, "min" );
+    if ( seconds > 0  ) next = number ( next, last, seconds, digits, "s" );
+    return done( first, next );
+  }
+
+  static std::string to_string( double_ns_t t, int digits = 3 )
+  {
+    char buffer[max_size];
+    return { buffer, format( buffer, buffer + max_size, t, digits ) };
+  }
+
+  static std::string to_string( double_ns_t t, ns_t units, int digits = 3 )
+  {
+    char buffer[max_size];
+    return { buffer, format( buffer, buffer + max_size, t, units, digits ) };
+  }
+
+  static std::string to_string( double_ns_t t, hms_t, int digits = 3 )
+  {
+    char buffer[max_size];
+    return { buffer, format( buffer, buffer + max_size, t, hms, digits ) };
+  }
+
+private:
+  // value with digits after the decimal point, trailing zeroes removed except
+  // if the entire fraction is zero, followed by suffix; nullptr if out of room.
+  // Digits are produced in a scratch buffer first, so that only the trimmed
+  // text has to fit.
+  static char* number( char* first, char* last, long double value, int digits, const char* suffix )
+  {
+    if ( first == nullptr ) return nullptr;
+    if ( digits < 0 ) digits = 0;
+    value = Round( value, digits ); // ties away from zero, as std::round
+    char scratch[max_size];
+    auto end = scratch + max_size - 3; // room to append ".0" and terminate
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    auto [next, error] = std::to_chars( scratch, end, static_cast<double>( value ), std::chars_format::fixed, digits );
+    if ( error != std::errc{} ) return nullptr;
+#else
+    auto size = std::snprintf( scratch, static_cast<std::size_t>( end - scratch ), "%.*f", digits, static_cast<double>( value ) );
+    if ( size < 0 or size >= end - scratch ) return nullptr;
+    auto next = scratch + size;
+#endif
+    auto point = scratch;
+    while ( point != next and *point != '.' ) ++point;
+    if ( point == next ) {
+      *next++ = '.';
+      *next++ = '0';
+    }
+    else {
+      while ( next - point > 2 and next[-1] == '0' ) --next;
+    }
+    *next = '\0';
+    return append( append( first, last, scratch ), last, suffix );
+  }
+
+  static char* integer( char* first, char* last, unsigned long long value, const char* suffix )
+  {
+    if ( first == nullptr ) return nullptr;
+    auto [next, error] = std::to_chars( first, last, value );
+    if ( error != std::errc{} ) return nullptr;
+    return append( next, last, suffix );
+  }
+
+  static char* done( char* first, char* next ) { return ( next == nullptr ) ? first : next; }
+
+  static char* append( char* first, char* last, const char* text )
+  {
+    if ( first == nullptr ) return nullptr;
+    while ( *text != '\0' ) {
+      if ( first == last ) return nullptr;
+      *first++ = *text++;
+    }
+    return first;
   }
 
 };
@@ -18,30 +18,73 @@
  * @function Objection::set_drainTime defaults to SC_ZERO_TIME
  * @function Objection::set_maxTimeout will cause timeout monitoring to start if called with a non-zero time. It can be set multiple times.
  *
+ * For frequently raised objections (e.g., one per transaction), use an
+ * Objection::Category instead. Categories are interned by name once, and
+ * each keeps an atomic count, so raising and dropping is O(1) and does not
+ * allocate. Names are only reported when SC_DEBUG verbosity is enabled.
+ *
+ *   Objection::Category busy{ "consumer" }; // e.g., a module member
+ *   ...
+ *   Objection::Scope objection{ busy };     // raise now, drop at end of scope
+ *
+ * A Category may also be attached to an sc_object. Its raises and drops are
+ * then counted incrementally by that object and each of its ancestors, so a
+ * subtree (e.g., top.m1) can have its own drain time and events that tell
+ * when it has gone quiet, independently of the rest of the simulation.
+ *
+ *   Objection::Category busy{ "m1.busy", m1 };
+ *   Objection::set_drainTime( m1, 10_ns );
+ *   wait( Objection::drained_event( m1 ) ); // m1 and below idle for 10 ns
+ *
+ * Every name (objection or category) also accumulates statistics: raises,
+ * total and longest sim time held, wall time held, and whether it is still
+ * held. Objection::report_statistics() lists them, longest held first; it is
+ * called automatically when the maxTimeout fires, so the report shows what
+ * kept the simulation alive.
+ *
+ * Host (OS) threads, e.g. co-simulation bridges, must not touch the above.
+ * They use an Objection::Async channel instead, created during elaboration.
+ * Its raise/drop only update an atomic count; the first raise and last drop
+ * are passed to the SystemC thread via async_request_update(), where the
+ * channel raises or drops its category so drain and shutdown decisions stay
+ * on the kernel thread.
+ *
  */
 
 #include <systemc>
+#include "report.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <map>
 #include <string>
 #include <set>
 #include <utility>
+#include <vector>
 using namespace std::literals;
 
 struct Objection
 {
+private:
+  struct Node; // see below
+public:
 
   /* @method Objection creates and raises an objection
    * @parameter name specifies the purpose of this objection to aid debug.
    * @parameter verbose causes all state changes to be dumped. Defaults to false.
    */
   explicit Objection( const std::string& name, sc_core::sc_verbosity verbosity = sc_core::SC_HIGH, bool quiet = false ) ///< Create an objection
-  : m_name( name ), m_verbosity_level( verbosity ), m_quiet( quiet )
+  : m_name( name ), m_verbosity_level( verbosity ), m_quiet( quiet ), m_statistic( statistic( name ) )
   {
     sc_assert( not name.empty() and s_objections.count( m_name ) == 0 ); // name required and must be unique
     s_objections.emplace( m_name );
+    hold( m_statistic );
     if( not get_quiet() )
       SC_REPORT_INFO_VERB( msg_type
                          , ( "Raising objection "s + m_name
-                           + " at "s + sc_core::sc_time_stamp().to_string()
+                           + " at "s + Doulos::time_stamp()
                            ).c_str()
                          , m_verbosity_level
       );
@@ -57,10 +100,11 @@ struct Objection
     auto elt = s_objections.find( m_name );
     sc_assert( elt != s_objections.end() );
     s_objections.erase( elt );
+    release( m_statistic );
     if( not get_quiet() )
       SC_REPORT_INFO_VERB( msg_type
                          , ( "Dropping objection "s + m_name
-                           + " at "s + sc_core::sc_time_stamp().to_string()
+                           + " at "s + Doulos::time_stamp()
                            ).c_str()
                          , m_verbosity_level
       );
@@ -68,32 +112,31 @@ struct Objection
   }
 
   /* @method total returns the total number of objection objects created during the lifetime of the program. */
-  static size_t total() { return s_created; } ///< Return total times used
+  static size_t total() { return s_created.load( std::memory_order_relaxed ); } ///< Return total times used
                                               ///
-  /* @method count returns the total number of objection objects currently active. */
-  static size_t count() { return s_objections.size(); }
+  /* @method count returns the total number of objections currently raised (named and by category). */
+  static size_t count() { return s_objections.size() + s_active.load( std::memory_order_relaxed ); }
   bool set_quiet( bool flag = true ) { std::swap(m_quiet, flag); return flag; }
   bool get_quiet() { return m_quiet; }
 
   /* @method monitor_objections shuts down simulation (i.e., issues `sc_stop()`) after all objections dropped and reached drain time. */
   inline static void monitor_objections( const std::string& name )
   { 
-    static std::string last_name{}; //< records last objection dropping to help debug
-    last_name = name;
+    s_last_dropped = name;
     // Run until drain-time reached if still simulating
-    if( not s_objections.empty() or not sc_core::sc_is_running() ) return;
+    if( count() != 0 or not sc_core::sc_is_running() ) return;
     static sc_core::sc_event objections_dropped;
-    objections_dropped.notify(); //< ignored when spawning
+    objections_dropped.notify( sc_core::SC_ZERO_TIME ); //< ignored when spawning; may be called from update()
     // Launch a process once (static) to wait until the end of the drain-time.
     // Then shutdown the simulation if no objections are present
     static auto h = sc_core::sc_spawn( []()
     {
       for(;;) {
         sc_core::wait( s_drainTime );
-        if( s_objections.empty() ) {
+        if( count() == 0 ) {
           SC_REPORT_INFO_VERB( msg_type
                              , ( "Shutting down due to last objection lowered in "s
-                               + last_name
+                               + s_last_dropped
                                ).c_str()
                              , sc_core::SC_NONE );
           sc_core::sc_stop();
@@ -122,6 +165,7 @@ struct Objection
       s_timeout_process = sc_core::sc_spawn( []()
       {
         wait( s_timeoutMax );
+        report_statistics( sc_core::SC_NONE ); // who kept us running?
         auto note{ "Shutting down due to timeoutMax reached"s };
         SC_REPORT_ERROR( msg_type, note.c_str() );
         sc_core::sc_stop();
@@ -138,17 +182,282 @@ struct Objection
   /* @method Objection::get_timeoutTime returns the actual time for the timeout. */
   inline static sc_core::sc_time get_timeoutTime() { return s_timeoutTime; }
 
+  /* @method Objection::report_statistics lists per-name activity, longest total sim time held first. */
+  inline static void report_statistics( sc_core::sc_verbosity verbosity = sc_core::SC_MEDIUM )
+  {
+    if( s_statistics.empty() ) return;
+    auto now = sc_core::sc_time_stamp();
+    auto wall_now = std::chrono::steady_clock::now();
+    std::vector<Statistic> table{ s_statistics }; // includes holds still in progress
+    for( auto& row : table ) {
+      if( row.held == 0 ) continue;
+      auto span = now - row.since;
+      row.total += span;
+      row.longest = std::max( row.longest, span );
+      row.wall += std::chrono::duration<double>( wall_now - row.wall_since ).count();
+    }
+    std::sort( table.begin(), table.end(), []( const auto& lhs, const auto& rhs ){ return lhs.total > rhs.total; } );
+    auto text = "Objection statistics at "s + now.to_string() + " (last dropped: "s + s_last_dropped + ")\n"s;
+    char line[256];
+    std::snprintf( line, sizeof( line ), "  %-32s %10s %14s %14s %10s  %s\n", "NAME", "RAISES", "TOTAL HELD", "LONGEST", "WALL(s)", "HELD NOW" );
+    text += line;
+    for( const auto& row : table ) {
+      std::snprintf( line, sizeof( line ), "  %-32s %10zu %14s %14s %10.3f  %s\n"
+                   , row.name.c_str(), row.raises, row.total.to_string().c_str(), row.longest.to_string().c_str(), row.wall
+                   , ( row.held == 0 ) ? "-" : ( std::to_string( row.held ) + " since "s + row.since.to_string() ).c_str() );
+      text += line;
+    }
+    SC_REPORT_INFO_VERB( msg_type, text.c_str(), verbosity );
+  }
+
+  /* @method Objection::count returns the objections raised by categories attached at or below scope. */
+  static size_t count( const sc_core::sc_object* scope ) { return node( scope ).count; }
+
+  /* @method Objection::set_drainTime sets how long scope's subtree must stay idle before drained_event( scope ). */
+  inline static void set_drainTime( const sc_core::sc_object* scope, const sc_core::sc_time& t )
+  {
+    auto& n = node( scope );
+    n.drain = t;
+    watch( n );
+  }
+
+  /* @method Objection::dropped_event is notified (next delta) each time the last objection in scope's subtree drops. */
+  static const sc_core::sc_event& dropped_event( const sc_core::sc_object* scope ) { return node( scope ).dropped; }
+
+  /* @method Objection::drained_event is notified once scope's subtree has remained idle for its drain time. */
+  static const sc_core::sc_event& drained_event( const sc_core::sc_object* scope )
+  {
+    auto& n = node( scope );
+    watch( n );
+    return n.drained;
+  }
+
+  /* @class Objection::Category is a cheap handle to a named, counted objection.
+   * Construct once (the name is interned); then raise/drop as often as needed.
+   * Categories with the same name share one count. If scope is given, raises
+   * are also counted by scope and its ancestors.
+   */
+  class Category
+  {
+  public:
+    explicit Category( const std::string& name, const sc_core::sc_object* scope = nullptr )
+    : m_entry{ &*s_categories.try_emplace( name, 0u ).first }
+    , m_node{ ( scope != nullptr ) ? &node( scope ) : nullptr }
+    , m_statistic{ statistic( name ) }
+    {
+      sc_assert( not name.empty() );
+    }
+
+    void raise()
+    {
+      m_entry->second.fetch_add( 1, std::memory_order_relaxed );
+      s_active.fetch_add( 1, std::memory_order_relaxed );
+      ++s_created;
+      hold( m_statistic );
+      for( auto n = m_node; n != nullptr; n = n->parent ) {
+        if( n->count++ == 0 and n->watched ) n->raised.notify( sc_core::SC_ZERO_TIME );
+      }
+      if( tracking() ) report( "Raising" );
+    }
+
+    void drop()
+    {
+      auto previous = m_entry->second.fetch_sub( 1, std::memory_order_relaxed );
+      sc_assert( previous != 0 ); // unbalanced drop
+      release( m_statistic );
+      for( auto n = m_node; n != nullptr; n = n->parent ) {
+        sc_assert( n->count != 0 );
+        if( --n->count == 0 and sc_core::sc_is_running() ) n->dropped.notify( sc_core::SC_ZERO_TIME );
+      }
+      if( tracking() ) report( "Dropping" );
+      if( s_active.fetch_sub( 1, std::memory_order_relaxed ) == 1 ) monitor_objections( m_entry->first );
+    }
+
+    size_t             count() const { return m_entry->second.load( std::memory_order_relaxed ); }
+    const std::string& name()  const { return m_entry->first; }
+
+  private:
+    static bool tracking() { return sc_core::sc_report_handler::get_verbosity_level() >= sc_core::SC_DEBUG; }
+    void report( const char* action ) const
+    {
+      SC_REPORT_INFO_VERB( msg_type
+                         , ( action + " objection "s + name()
+                           + " ("s + std::to_string( count() ) + " raised)"s
+                           + " at "s + Doulos::time_stamp()
+                           ).c_str()
+                         , sc_core::SC_DEBUG
+      );
+    }
+    std::pair<const std::string, std::atomic<size_t>>* m_entry; //< interned name and count
+    Node*                                              m_node;  //< innermost scope, if any
+    size_t                                             m_statistic; //< index into s_statistics
+  };
+
+  /* @class Objection::Scope raises a Category (or Async) for the lifetime of the scope. */
+  template<typename Counted>
+  class Scope
+  {
+  public:
+    explicit Scope( Counted& counted ) : m_counted{ counted } { m_counted.raise(); }
+    ~Scope() { m_counted.drop(); }
+    Scope( const Scope& ) = delete;
+    Scope& operator=( const Scope& ) = delete;
+  private:
+    Counted& m_counted;
+  };
+
+  /* @class Objection::Async may be raised and dropped from any thread.
+   * Must be constructed during elaboration. The channel's category (named
+   * after the channel) is raised on the SystemC thread while the count is
+   * non-zero, so statistics count busy periods rather than host raises.
+   */
+  class Async : public sc_core::sc_prim_channel
+  {
+  public:
+    explicit Async( const char* instance, const sc_core::sc_object* scope = nullptr )
+    : sc_core::sc_prim_channel{ instance }
+    , m_category{ name(), scope }
+    {
+    }
+
+    // Any thread
+    void raise()
+    {
+      if( m_count.fetch_add( 1, std::memory_order_acq_rel ) == 0 ) async_request_update();
+    }
+
+    void drop()
+    {
+      auto previous = m_count.fetch_sub( 1, std::memory_order_acq_rel );
+      assert( previous != 0 ); // unbalanced drop (sc_assert is not thread-safe)
+      if( previous == 1 ) async_request_update();
+    }
+
+    size_t count() const { return m_count.load( std::memory_order_relaxed ); }
+
+  private:
+    // SystemC thread: catch up with whatever the host threads did meanwhile
+    void update() override
+    {
+      bool busy = ( m_count.load( std::memory_order_acquire ) != 0 );
+      if( busy == m_raised ) return;
+      m_raised = busy;
+      if( busy ) {
+#if SYSTEMC_VERSION >= 20171012
+        async_attach_suspending(); // do not end by starvation while host work is in flight
+#endif
+        m_category.raise();
+      }
+      else {
+        m_category.drop();
+#if SYSTEMC_VERSION >= 20171012
+        async_detach_suspending();
+#endif
+      }
+    }
+
+    std::atomic<size_t> m_count{ 0u };
+    Category            m_category;
+    bool                m_raised{ false }; //< m_category currently raised (SystemC thread only)
+  };
+
 private:
 
+  // Activity per name, kept in a flat table so that hold/release are cheap
+  struct Statistic
+  {
+    std::string      name{};
+    size_t           raises{ 0u };
+    size_t           held{ 0u };  //< currently raised
+    sc_core::sc_time since{};     //< when held last became non-zero
+    sc_core::sc_time total{};     //< sim time with held non-zero
+    sc_core::sc_time longest{};   //< longest continuous hold
+    double           wall{ 0.0 }; //< seconds with held non-zero
+    std::chrono::steady_clock::time_point wall_since{};
+  };
+
+  inline static size_t statistic( const std::string& name )
+  {
+    auto [ it, added ] = s_statistic_index.try_emplace( name, s_statistics.size() );
+    if( added ) s_statistics.push_back( Statistic{ name } );
+    return it->second;
+  }
+
+  inline static void hold( size_t index )
+  {
+    auto& row = s_statistics[index];
+    ++row.raises;
+    if( row.held++ != 0 ) return;
+    row.since = sc_core::sc_time_stamp();
+    row.wall_since = std::chrono::steady_clock::now();
+  }
+
+  inline static void release( size_t index )
+  {
+    auto& row = s_statistics[index];
+    if( --row.held != 0 ) return;
+    auto span = sc_core::sc_time_stamp() - row.since;
+    row.total += span;
+    row.longest = std::max( row.longest, span );
+    row.wall += std::chrono::duration<double>( std::chrono::steady_clock::now() - row.wall_since ).count();
+  }
+
+  // Objections counted per sc_object; each node also counts its descendants
+  struct Node
+  {
+    Node*                      parent{ nullptr };
+    size_t                     count{ 0u };
+    sc_core::sc_time           drain{};
+    bool                       watched{ false }; //< drain process spawned
+    sc_core::sc_event          raised{};         //< count left zero (only if watched)
+    sc_core::sc_event          dropped{};        //< count reached zero
+    sc_core::sc_event          drained{};        //< zero for the drain time
+  };
+
+  inline static Node& node( const sc_core::sc_object* scope )
+  {
+    sc_assert( scope != nullptr );
+    auto [ it, added ] = s_nodes.try_emplace( scope );
+    if( added ) {
+      auto parent = scope->get_parent_object();
+      if( parent != nullptr ) it->second.parent = &node( parent );
+    }
+    return it->second;
+  }
+
+  // Spawn (once per node) the processes that notify drained after the last
+  // drop, unless raised again within the drain time
+  inline static void watch( Node& n )
+  {
+    if( n.watched ) return;
+    n.watched = true;
+    auto spawn_on = []( sc_core::sc_event& trigger, const char* basename, auto action ) {
+      sc_core::sc_spawn_options options;
+      options.spawn_method();
+      options.dont_initialize();
+      options.set_sensitivity( &trigger );
+      sc_core::sc_spawn( action, sc_core::sc_gen_unique_name( basename ), &options );
+    };
+    spawn_on( n.dropped, "objection_drain", [&n]() { if( n.count == 0 ) { n.drained.cancel(); n.drained.notify( n.drain ); } } );
+    spawn_on( n.raised,  "objection_raise", [&n]() { if( n.count != 0 ) n.drained.cancel(); } );
+  }
+
   // Per object properties to aid debug
   std::string m_name{};
   sc_core::sc_verbosity m_verbosity_level{};
   bool m_quiet;
+  size_t m_statistic{}; //< index into s_statistics
 
   // Static stuff (s_ prefix)
   static constexpr const char* const       msg_type { "/Doulos/Objection" };
-  inline static size_t                     s_created{ 0u };
+  inline static std::atomic<size_t>        s_created{ 0u };
   inline static std::set<std::string>      s_objections{};
+  inline static std::map<std::string,std::atomic<size_t>> s_categories{}; //< interned Category names
+  inline static std::atomic<size_t>        s_active{ 0u }; //< raised via categories
+  inline static std::map<const sc_core::sc_object*,Node> s_nodes{}; //< per scope counts
+  inline static std::vector<Statistic>     s_statistics{};
+  inline static std::map<std::string,size_t> s_statistic_index{};
+  inline static std::string                s_last_dropped{}; //< records last objection dropping to help debug
   inline static sc_core::sc_time           s_drainTime{};
   inline static sc_core::sc_time           s_timeoutMax{};
   inline static sc_core::sc_time           s_timeoutTime{};
@@ -0,0 +1,368 @@
+#pragma once
+
+/*! Aggregate timing of named, nestable zones
+
+Where Timer reports every measurement, the Profiler accumulates them so a
+hot section executed thousands of times yields one line in a report.
+
+  Example: {
+    PROFILE_ZONE( "transfer" ); //< times the enclosing scope
+    for( ... ) {
+      PROFILE_ZONE( "compute" ); //< nested under "transfer"
+      Do_some_hard_work();
+    }
+  }
+  ...
+  Profiler::report(); //< or let it print to std::cout at exit
+
+Zones nest by the order they are entered on each thread, so the same zone
+reached from different callers appears under each caller. SystemC processes
+share their OS thread as coroutines, so inside a process each process counts
+as a thread of its own; a zone may then span wait(). Every thread
+accumulates into its own tree without locking; the report merges the trees
+by path and shows count, total, mean, min, max and p99 per zone, with
+children sorted by total time. p99 is estimated from a log-linear histogram
+(within 25%). Define NPROFILE to compile zones out entirely.
+
+The report at exit runs during static destruction, after SystemC may have
+gone, so it only writes to std::cout. SystemC models should call
+Profiler::report() (e.g., before Debug::exit_status()), which issues an
+SC_REPORT and replaces the report at exit.
+
+Like Timer, measurements use std::chrono::steady_clock and include the
+(small) cost of reading it twice per zone. See ABOUT_TIMER.md.
+*/
+
+#if __has_include(<systemc>)
+#include <systemc> // so Profiler is the same in every translation unit
+#endif
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+#include "chronout.hpp"
+using namespace std::literals;
+
+class Profiler
+{
+private:
+  struct Thread_data; // see below
+public:
+  using clock = std::chrono::steady_clock;
+
+  //----------------------------------------------------------------------------
+  // Identifies a zone by name; intended to be static (see PROFILE_ZONE)
+  class Site
+  {
+  public:
+    explicit Site( const std::string& name ) : m_id{ intern( name ) } {}
+    std::size_t id() const { return m_id; }
+  private:
+    std::size_t m_id;
+  };
+
+  //----------------------------------------------------------------------------
+  // Times its own lifetime as a child of the innermost enclosing zone
+  class Zone
+  {
+  public:
+    explicit Zone( const Site& site )
+    : m_thread{ thread_data() }
+    , m_node{ m_thread.enter( site.id() ) }
+    , m_start{ clock::now() }
+    {
+    }
+    Zone( const Zone& ) = delete;
+    Zone& operator=( const Zone& ) = delete;
+    ~Zone() { m_thread.leave( m_node, clock::now() - m_start ); }
+  private:
+    Thread_data&        m_thread;
+    std::size_t         m_node;
+    clock::time_point   m_start;
+  };
+
+  // Merged statistics of one zone path
+  struct Statistic {
+    std::string               path; // names joined by '/'
+    std::size_t               depth{ 0 };
+    std::uint64_t             count{ 0 };
+    std::chrono::nanoseconds  total{ 0 };
+    std::chrono::nanoseconds  min{ std::chrono::nanoseconds::max() };
+    std::chrono::nanoseconds  max{ 0 };
+    std::chrono::nanoseconds  p99{ 0 };
+    std::chrono::nanoseconds  mean() const { return count == 0 ? total : total / static_cast<std::int64_t>( count ); }
+  };
+
+  // Depth-first, children sorted by decreasing total. Call when no zones are
+  // active on other threads (e.g., after sc_start returns).
+  static std::vector<Statistic> statistics();
+
+  static std::string to_string();
+  static void report(); // also cancels the report at exit
+  static void reset(); // forget everything measured so far
+  static void set_report_at_exit( bool flag = true ) { s_registry().report_at_exit = flag; }
+
+private:
+  //----------------------------------------------------------------------------
+  // Log-linear histogram: 4 sub-buckets per power of two nanoseconds
+  static constexpr int sub_bits = 2;
+  static constexpr std::size_t buckets = 64 << sub_bits;
+  static std::size_t bucket( std::uint64_t ns )
+  {
+    if( ns < ( 1u << sub_bits ) ) return ns;
+    int msb = 63 - __builtin_clzll( ns );
+    return ( std::size_t( msb - sub_bits + 1 ) << sub_bits ) | ( ( ns >> ( msb - sub_bits ) ) & ( ( 1u << sub_bits ) - 1 ) );
+  }
+  static std::uint64_t bucket_limit( std::size_t index ) // largest value in bucket
+  {
+    if( index < ( 1u << sub_bits ) ) return index;
+    auto shift = int( index >> sub_bits ) - 1;
+    auto base  = ( std::uint64_t{ 1u << sub_bits } | ( index & ( ( 1u << sub_bits ) - 1 ) ) ) << shift;
+    return base + ( std::uint64_t{ 1 } << shift ) - 1;
+  }
+
+  struct Node {
+    std::size_t   site;
+    std::size_t   parent;
+    std::vector<std::pair<std::size_t,std::size_t>> children{}; // site, node
+    std::uint64_t count{ 0 };
+    std::uint64_t total{ 0 }; // ns
+    std::uint64_t min{ std::numeric_limits<std::uint64_t>::max() };
+    std::uint64_t max{ 0 };
+    std::array<std::uint64_t, buckets> histogram{};
+  };
+
+  // Zone tree of one thread; node 0 is the root
+  struct Thread_data {
+    std::vector<Node> nodes{ Node{ 0, 0 } };
+    std::size_t       current{ 0 };
+
+    std::size_t enter( std::size_t site )
+    {
+      for( const auto& [child_site, child] : nodes[current].children ) {
+        if( child_site == site ) return current = child;
+      }
+      nodes.push_back( Node{ site, current } );
+      auto child = nodes.size() - 1;
+      nodes[current].children.emplace_back( site, child );
+      return current = child;
+    }
+
+    void leave( std::size_t node, clock::duration elapsed )
+    {
+      auto ns = static_cast<std::uint64_t>( std::chrono::duration_cast<std::chrono::nanoseconds>( elapsed ).count() );
+      auto& n = nodes[node];
+      ++n.count;
+      n.total += ns;
+      n.min = std::min( n.min, ns );
+      n.max = std::max( n.max, ns );
+      ++n.histogram[ bucket( ns ) ];
+      current = n.parent;
+    }
+  };
+
+  struct Registry {
+    std::mutex                                mutex;
+    std::vector<std::string>                  names;
+    std::map<std::string,std::size_t>         ids;
+    std::vector<std::shared_ptr<Thread_data>> threads; // outlive their threads
+    bool                                      report_at_exit{ true };
+    ~Registry() { if( report_at_exit and not threads.empty() ) std::cout << to_string_locked( *this ); }
+  };
+
+  static Registry& s_registry() { static Registry registry; return registry; }
+
+  static std::size_t intern( const std::string& name )
+  {
+    auto& registry = s_registry();
+    std::lock_guard<std::mutex> lock{ registry.mutex };
+    auto [it, added] = registry.ids.emplace( name, registry.names.size() );
+    if( added ) registry.names.push_back( name );
+    return it->second;
+  }
+
+  // Identifies the SystemC process running zones, or nullptr outside processes
+  static const void* context()
+  {
+  #ifdef SYSTEMC_INCLUDED
+    return sc_core::sc_get_current_process_handle().get_process_object();
+  #else
+    return nullptr;
+  #endif
+  }
+
+  // Zone tree of the calling thread or, within SystemC, process
+  static Thread_data& thread_data()
+  {
+    thread_local std::map<const void*,std::shared_ptr<Thread_data>> trees;
+    thread_local const void*  last_context{ nullptr };
+    thread_local Thread_data* last{ nullptr };
+    auto here = context();
+    if( last != nullptr and here == last_context ) return *last;
+    auto& data = trees[ here ];
+    if( not data ) {
+      auto& registry = s_registry();
+      data = std::make_shared<Thread_data>();
+      std::lock_guard<std::mutex> lock{ registry.mutex };
+      registry.threads.push_back( data );
+    }
+    last_context = here;
+    last = data.get();
+    return *data;
+  }
+
+  static std::vector<Statistic> statistics_locked( const Registry& registry );
+  static std::string to_string_locked( const Registry& registry );
+};
+
+//------------------------------------------------------------------------------
+#ifdef NPROFILE
+#define PROFILE_ZONE(name) do {} while(0)
+#else
+#define PROFILE_CONCAT_(a,b) a##b
+#define PROFILE_CONCAT(a,b) PROFILE_CONCAT_(a,b)
+#define PROFILE_ZONE(name) PROFILE_ZONE_(name,__COUNTER__)
+#define PROFILE_ZONE_(name,n) \
+  static const Profiler::Site PROFILE_CONCAT(profile_site_,n){ name }; \
+  Profiler::Zone PROFILE_CONCAT(profile_zone_,n){ PROFILE_CONCAT(profile_site_,n) }
+#endif
+
+//------------------------------------------------------------------------------
+inline std::vector<Profiler::Statistic> Profiler::statistics()
+{
+  auto& registry = s_registry();
+  std::lock_guard<std::mutex> lock{ registry.mutex };
+  return statistics_locked( registry );
+}
+
+inline std::vector<Profiler::Statistic> Profiler::statistics_locked( const Registry& registry )
+{
+  // Merge per-thread trees by path
+  struct Merged {
+    Statistic                          statistic;
+    std::array<std::uint64_t, buckets> histogram{};
+    std::map<std::string,std::size_t>  children{}; // name to index in tree
+  };
+  std::vector<Merged> tree( 1 );
+  for( const auto& thread : registry.threads ) {
+    std::vector<std::size_t> merged( thread->nodes.size(), 0 );
+    for( std::size_t i = 1; i < thread->nodes.size(); ++i ) { // parents precede children
+      const auto& node = thread->nodes[i];
+      const auto& name = registry.names[ node.site ];
+      auto parent = merged[ node.parent ];
+      auto found = tree[parent].children.find( name );
+      if( found == tree[parent].children.end() ) {
+        Merged m;
+        m.statistic.path  = ( parent == 0 ? ""s : tree[parent].statistic.path + "/"s ) + name;
+        m.statistic.depth = tree[parent].statistic.depth + 1;
+        tree.push_back( std::move( m ) );
+        found = tree[parent].children.emplace( name, tree.size() - 1 ).first;
+      }
+      auto& m = tree[ found->second ];
+      merged[i] = found->second;
+      m.statistic.count += node.count;
+      m.statistic.total += std::chrono::nanoseconds( node.total );
+      if( node.count != 0 ) {
+        m.statistic.min = std::min( m.statistic.min, std::chrono::nanoseconds( node.min ) );
+        m.statistic.max = std::max( m.statistic.max, std::chrono::nanoseconds( node.max ) );
+      }
+      for( std::size_t b = 0; b < buckets; ++b ) m.histogram[b] += node.histogram[b];
+    }
+  }
+  for( auto& m : tree ) {
+    auto& s = m.statistic;
+    if( s.count == 0 ) { s.min = std::chrono::nanoseconds{ 0 }; continue; }
+    auto wanted = ( s.count * 99 + 99 ) / 100; // ceiling of 99%
+    std::uint64_t seen = 0;
+    for( std::size_t b = 0; b < buckets; ++b ) {
+      seen += m.histogram[b];
+      if( seen >= wanted ) {
+        s.p99 = std::min( s.max, std::chrono::nanoseconds( bucket_limit( b ) ) );
+        break;
+      }
+    }
+  }
+  // Flatten depth-first
+  std::vector<Statistic> result;
+  auto visit = [&]( auto& self, std::size_t index ) -> void {
+    std::vector<std::size_t> children;
+    for( const auto& child : tree[index].children ) children.push_back( child.second );
+    std::sort( children.begin(), children.end(), [&]( auto lhs, auto rhs ) {
+      return tree[lhs].statistic.total > tree[rhs].statistic.total;
+    } );
+    for( auto child : children ) {
+      result.push_back( tree[child].statistic );
+      self( self, child );
+    }
+  };
+  visit( visit, 0 );
+  return result;
+}
+
+inline std::string Profiler::to_string()
+{
+  auto& registry = s_registry();
+  std::lock_guard<std::mutex> lock{ registry.mutex };
+  return to_string_locked( registry );
+}
+
+inline std::string Profiler::to_string_locked( const Registry& registry )
+{
+  std::ostringstream os;
+  auto threads = registry.threads.size();
+  os << "Profile of " << threads << " thread" << ( threads == 1 ? "" : "s" ) << ":\n"
+     << std::left << std::setw(32) << "  zone" << std::right
+     << std::setw(10) << "count" << std::setw(12) << "total" << std::setw(12) << "mean"
+     << std::setw(12) << "min" << std::setw(12) << "max" << std::setw(12) << "p99" << '\n';
+  for( const auto& s : statistics_locked( registry ) ) {
+    auto name = std::string( 2 * s.depth, ' ' ) + s.path.substr( s.path.find_last_of( '/' ) + 1 );
+    os << std::left << std::setw(32) << name << std::right
+       << std::setw(10) << s.count
+       << std::setw(12) << Chronout::to_string( s.total )
+       << std::setw(12) << Chronout::to_string( s.mean() )
+       << std::setw(12) << Chronout::to_string( s.min )
+       << std::setw(12) << Chronout::to_string( s.max )
+       << std::setw(12) << Chronout::to_string( s.p99 ) << '\n';
+  }
+  return os.str();
+}
+
+inline void Profiler::report()
+{
+  set_report_at_exit( false );
+  #ifdef SYSTEMC_INCLUDED
+  SC_REPORT_INFO_VERB( "/Doulos/profiler", to_string().c_str(), sc_core::SC_NONE );
+  #else
+  std::cout << to_string();
+  #endif
+}
+
+inline void Profiler::reset()
+{
+  auto& registry = s_registry();
+  std::lock_guard<std::mutex> lock{ registry.mutex };
+  for( auto& thread : registry.threads ) {
+    for( auto& node : thread->nodes ) {
+      node.count = node.total = node.max = 0;
+      node.min = std::numeric_limits<std::uint64_t>::max();
+      node.histogram.fill( 0 );
+    }
+  }
+}
+
+// TAGS: Doulos, SystemC, profiling, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <systemc>
+#include "chronout.hpp"
 #include <string>
 #if __has_include(<fmt/format.h>)
   #define HAS_FMT_FORMAT
@@ -83,7 +84,7 @@
   #define REPORT_DEBUG(mesg)      REPORT_INFO_VERB(  msg_type,\
     Doulos::text( std::string{"Debug: "} + std::string{mesg} \
     + std::string{"\nFile:"} + std::string{__FILE__} + std::string{" Line:"} + std::to_string(__LINE__)\
-    + std::string{" at "} + ::sc_core::sc_time_stamp().to_string()\
+    + std::string{" at "} + ::Doulos::time_stamp()\
     , ::sc_core::SC_INFO, ::sc_core::SC_DEBUG), ::sc_core::SC_DEBUG )
   #define REPORT_NUM(var) REPORT_DEBUG( std::string{#var} + std::string{"="} + std::to_string(var) )
   #define REPORT_STR(var) REPORT_DEBUG( std::string{#var} + std::string{"="} + var                 )
@@ -112,4 +113,18 @@ static inline const char* text( const std::string& the_string
   return result.c_str();
 }
 
+// sc_time_stamp().to_string(), reformatted only when simulated time advances
+// so that every report within a time step reuses the same text. Not static, so
+// the whole program shares one cache.
+inline const std::string& time_stamp() {
+  static sc_dt::uint64 ticks{ 0 };
+  static std::string   text{};
+  const auto& now = ::sc_core::sc_time_stamp();
+  if( text.empty() or now.value() != ticks ) {
+    ticks = now.value();
+    text  = now.to_string();
+  }
+  return text;
+}
+
 }//endnamespace Doulos
@@ -0,0 +1,117 @@
+#pragma once
+
+#include "workload.hpp"
+#include "debug.hpp"
+#include <systemc>
+#include <chrono>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+using namespace std::literals;
+
+// Instantiates --nModules Workload_modules and reports how fast and how big
+// the result is. See ABOUT_SCALE.md for the options.
+struct Top_module : sc_core::sc_module
+{
+  using sc_report_handler = sc_core::sc_report_handler;
+  using clock = std::chrono::steady_clock;
+
+  static constexpr const char *msg_type = "/Doulos/scale/top";
+
+  // Sub-modules
+  std::vector<std::unique_ptr<Workload_module>> workloads{};
+
+  // Constructor
+  explicit Top_module( const sc_core::sc_module_name& instance )
+    : sc_module( instance )
+  {
+    SC_HAS_PROCESS( Top_module );
+    SC_THREAD( run_thread );
+
+    Debug::parse_command_line(); // the knobs are needed now
+    auto config = Workload_module::Config{};
+    auto count = [](const char* name, size_t value){ return Debug::parsed( name ) ? Debug::get_count( name ) : value; };
+    auto modules     = count( "nModules", 10 );
+    config.processes = count( "nProcesses", config.processes );
+    config.fanout    = count( "nFanout", config.fanout );
+    config.depth     = count( "nDepth", config.depth );
+    config.stack     = count( "nStack", config.stack );
+    if( Debug::parsed( "dMethods" ) ) config.methods = Debug::get_value( "dMethods" );
+    if( Debug::parsed( "tPeriod" ) )  config.period  = Debug::get_time( "tPeriod" );
+    m_run = Debug::parsed( "tRun" ) ? Debug::get_time( "tRun" ) : sc_core::sc_time{ 10, sc_core::SC_US };
+
+    m_rss_before = resident_bytes();
+    for( size_t i = 0; i < modules; ++i ) {
+      workloads.push_back( std::make_unique<Workload_module>( ( "w"s + std::to_string( i ) ).c_str(), config ) );
+    }
+    m_config = config;
+  }
+
+  void before_end_of_elaboration() override
+  {
+    sc_report_handler::set_actions( sc_core::SC_WARNING, sc_core::SC_DISPLAY | sc_core::SC_LOG | sc_core::SC_INTERRUPT );
+    sc_report_handler::set_actions( sc_core::SC_ERROR, sc_core::SC_DISPLAY   | sc_core::SC_LOG | sc_core::SC_INTERRUPT );
+    sc_report_handler::set_actions( sc_core::SC_FATAL, sc_core::SC_DISPLAY   | sc_core::SC_LOG | sc_core::SC_STOP );
+  }
+
+  void start_of_simulation() override
+  {
+    Debug::stop_if_requested();
+    m_start = clock::now();
+    m_delta_start = sc_core::sc_delta_count();
+  }
+
+  void run_thread()
+  {
+    // Use this to stop --help gracefully and/or pre-simulation time errors.
+    wait( sc_core::SC_ZERO_TIME );
+    Debug::stop_if_requested();
+    wait( m_run );
+    sc_core::sc_stop();
+  }
+
+  void end_of_simulation() override
+  {
+    auto wall = std::chrono::duration<double>( clock::now() - m_start ).count();
+    auto rss  = resident_bytes();
+    size_t threads{}, methods{}, activations{}, transactions{};
+    for( const auto& w : workloads ) {
+      threads      += w->threads();
+      methods      += w->methods();
+      activations  += w->activations();
+      transactions += w->transactions();
+    }
+    auto processes = threads + methods + 2 * workloads.size(); // plus producer & consumer
+    auto deltas    = sc_core::sc_delta_count() - m_delta_start;
+    auto per_second = [wall]( double n ){ return ( wall > 0.0 ) ? n / wall : 0.0; };
+    std::ostringstream os;
+    os << std::fixed << std::setprecision(0)
+       << "\nWorkload\n"
+       << "--------\n"
+       << "      Modules: " << workloads.size() << " x " << m_config.processes << " workers"
+       << " (fan-out " << m_config.fanout << ", fifo depth " << m_config.depth << ")\n"
+       << "    Processes: " << processes << " (" << threads << " worker threads, " << methods << " worker methods)\n"
+       << "       Events: " << activations << " worker activations, " << per_second( double( activations ) ) << " per second\n"
+       << " Delta cycles: " << deltas << ", " << per_second( double( deltas ) ) << " per second\n"
+       << " Transactions: " << transactions << ", " << per_second( double( transactions ) ) << " per second\n"
+       << "       Memory: " << double( rss ) / ( 1024.0 * 1024.0 ) << " MiB resident, "
+       << ( ( processes > 0 and rss > m_rss_before ) ? ( rss - m_rss_before ) / processes : 0 ) << " bytes per process\n";
+    REPORT_ALWAYS( os.str() );
+  }
+
+private:
+  Workload_module::Config m_config{};
+  sc_core::sc_time        m_run{};
+  clock::time_point       m_start{};
+  sc_dt::uint64           m_delta_start{};
+  size_t                  m_rss_before{};
+};
+
+// TAGS: Doulos, SystemC, performance, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
@@ -0,0 +1,119 @@
+#include "workload.hpp"
+#include <algorithm>
+#include <fstream>
+#if __has_include(<unistd.h>)
+#include <unistd.h>
+#endif
+#if __has_include(<sys/resource.h>)
+#include <sys/resource.h>
+#endif
+using namespace sc_core;
+using namespace std::literals;
+
+//------------------------------------------------------------------------------
+// Constructor
+//------------------------------------------------------------------------------
+Workload_module::Workload_module( const sc_module_name& instance, const Config& config )
+  : sc_module{ instance }
+  , m_config{ config }
+  , m_fifo{ "fifo", static_cast<int>( std::max<size_t>( config.depth, 1 ) ) }
+  , m_events( ( config.processes + std::max<size_t>( config.fanout, 1 ) - 1 ) / std::max<size_t>( config.fanout, 1 ) )
+{
+  SC_HAS_PROCESS( Workload_module );
+  SC_THREAD( producer_thread );
+  SC_THREAD( consumer_thread );
+
+  m_config.fanout = std::max<size_t>( m_config.fanout, 1 );
+  m_config.methods = std::clamp( m_config.methods, 0.0, 1.0 );
+  for( size_t index = 0; index < m_config.processes; ++index ) {
+    auto& event = m_events[ index / m_config.fanout ];
+    // Spread methods evenly among the threads
+    auto is_method = size_t( double( index + 1 ) * m_config.methods ) != size_t( double( index ) * m_config.methods );
+    sc_spawn_options options;
+    options.set_sensitivity( &event );
+    options.dont_initialize();
+    if( is_method ) {
+      options.spawn_method();
+      sc_spawn( [this,index]{ worker_method( index ); }, ( "worker_method_"s + std::to_string( index ) ).c_str(), &options );
+      ++m_methods;
+    }
+    else {
+      if( m_config.stack != 0 ) options.set_stack_size( static_cast<int>( m_config.stack ) );
+      sc_spawn( [this,index]{ worker_thread( index ); }, ( "worker_thread_"s + std::to_string( index ) ).c_str(), &options );
+      ++m_threads;
+    }
+  }
+}
+
+//------------------------------------------------------------------------------
+// Processes
+//------------------------------------------------------------------------------
+void Workload_module::producer_thread()
+{
+  if( not m_events.empty() ) m_events.front().notify( SC_ZERO_TIME ); // start the ring
+  for( int value = 0;; ) {
+    // Twice the depth per period, so the producer also blocks on a full fifo
+    for( size_t i = 0; i < 2 * m_config.depth; ++i ) m_fifo.write( ++value );
+    wait( m_config.period );
+  }
+}
+
+void Workload_module::consumer_thread()
+{
+  for(;;) {
+    [[maybe_unused]] auto value = m_fifo.read();
+    ++m_transactions;
+  }
+}
+
+void Workload_module::worker_thread( size_t index )
+{
+  for(;;) {
+    activate( index );
+    wait(); // static sensitivity
+  }
+}
+
+void Workload_module::worker_method( size_t index )
+{
+  activate( index );
+}
+
+//------------------------------------------------------------------------------
+// Helpers
+//------------------------------------------------------------------------------
+void Workload_module::activate( size_t index )
+{
+  ++m_activations;
+  if( index % m_config.fanout != 0 ) return; // only the first of a group passes it on
+  auto next = index / m_config.fanout + 1;
+  if( next == m_events.size() ) m_events.front().notify( m_config.period );
+  else                          m_events[ next ].notify( SC_ZERO_TIME );
+}
+
+size_t resident_bytes()
+{
+#if defined(__linux__)
+  auto statm = std::ifstream{ "/proc/self/statm" };
+  size_t pages{}, resident{};
+  if( statm >> pages >> resident ) return resident * static_cast<size_t>( sysconf( _SC_PAGESIZE ) );
+#endif
+#if __has_include(<sys/resource.h>)
+  rusage usage{};
+  if( getrusage( RUSAGE_SELF, &usage ) == 0 ) {
+#if defined(__APPLE__)
+    return static_cast<size_t>( usage.ru_maxrss ); // bytes
+#else
+    return static_cast<size_t>( usage.ru_maxrss ) * 1024u; // KiB
+#endif
+  }
+#endif
+  return 0;
+}
+
+// TAGS: Doulos, SystemC, performance, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
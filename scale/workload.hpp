@@ -0,0 +1,73 @@
+#pragma once
+
+#include <systemc>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "debug.hpp"
+
+// One unit of scalable load: a producer/consumer pair connected by an sc_fifo
+// (as in trivial/) plus a configurable number of worker processes (as in
+// demo/'s Processes_module), some SC_METHODs and some SC_THREADs.
+//
+// Workers are split into groups of `fanout`, each group sensitive to one
+// event. Whenever a group runs, its first worker notifies the next group in
+// the following delta cycle, so activity ripples through every group once
+// per period before the ring wraps around with a timed notification.
+struct Workload_module : sc_core::sc_module
+{
+  using sc_module_name = sc_core::sc_module_name;
+  static constexpr const char* msg_type = "/Doulos/scale/workload";
+
+  struct Config {
+    size_t           processes{ 10 };  // workers per module
+    double           methods{ 0.5 };   // fraction of workers that are SC_METHODs
+    size_t           fanout{ 1 };      // workers woken by each event
+    size_t           depth{ 4 };       // fifo depth
+    size_t           stack{ 0 };       // thread stack size (0 => SystemC default)
+    sc_core::sc_time period{ 10, sc_core::SC_NS };
+  };
+
+  //----------------------------------------------------------------------------
+  // Constructors and overrides
+  Workload_module( const sc_module_name& instance, const Config& config );
+
+  //----------------------------------------------------------------------------
+  // Results
+  size_t threads()      const { return m_threads; }
+  size_t methods()      const { return m_methods; }
+  size_t activations()  const { return m_activations; } // worker runs
+  size_t transactions() const { return m_transactions; }
+
+private:
+  //----------------------------------------------------------------------------
+  // Processes
+  void producer_thread();
+  void consumer_thread();
+  void worker_thread( size_t index );
+  void worker_method( size_t index );
+
+  //----------------------------------------------------------------------------
+  // Helpers
+  void activate( size_t index ); // common to threads & methods
+
+  //----------------------------------------------------------------------------
+  // Data
+  Config                     m_config;
+  sc_core::sc_fifo<int>      m_fifo;
+  std::vector<sc_core::sc_event> m_events; // one per group of workers
+  size_t m_threads{ 0 };
+  size_t m_methods{ 0 };
+  size_t m_activations{ 0 };
+  size_t m_transactions{ 0 };
+};
+
+// Current resident set size in bytes (peak if the current size is unknown)
+size_t resident_bytes();
+
+// TAGS: Doulos, SystemC, performance, SOURCE
+// ----------------------------------------------------------------------------
+//
+// This file is licensed under Apache-2.0, and
+// Copyright 2022 David C Black <mailto:<david.black@doulos.com>>
+// See accompanying LICENSE or visit <https://www.apache.org/licenses/LICENSE-2.0.txt> for more details.
@@ -1,5 +1,4 @@
 #include "top.hpp"
-#include "timer.hpp"
 #include <string>
 #include <memory>
 
@@ -12,7 +11,6 @@ using namespace sc_core;
 
   // Place most of code on the heap -- sc_start will use this indirectly
   [[maybe_unused]] auto top = std::make_unique<Top_module>( "top" );
-  Timer::global().report( "Construction" );
   sc_start();
 
   if ( not sc_end_of_simulation_invoked() ) {
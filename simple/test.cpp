@@ -24,7 +24,7 @@ void Test_module::observer_thread()
     wait( producer_event );
     SC_REPORT_INFO_VERB(
           observerType.c_str(),
-          ( "At "s + sc_time_stamp().to_string()
+          ( "At "s + Doulos::time_stamp()
           + " observed production."s
           ).c_str(),
           SC_FULL
@@ -44,7 +44,7 @@ void Test_module::producer_thread()
         ++producer_total;
         SC_REPORT_INFO_VERB(
           producerType.c_str(),
-          ( "At "s + sc_time_stamp().to_string()
+          ( "At "s + Doulos::time_stamp()
           + " producer sent "s + to_string( producedData )
           ).c_str(),
           SC_DEBUG
@@ -85,7 +85,7 @@ void Test_module::consumer_method()
       if( consumedData == expectedData ) {
         SC_REPORT_INFO_VERB(
           consumerType.c_str(),
-          ( "At "s + sc_time_stamp().to_string()
+          ( "At "s + Doulos::time_stamp()
           + " correctly received "s + to_string( consumedData )
           ).c_str(),
           SC_DEBUG
@@ -144,14 +144,12 @@ void Test_module::start_of_simulation()
     ).c_str(),
     SC_NONE
   );
-  if ( Debug::trace_file() != nullptr ) {
-    sc_trace( Debug::trace_file(), clock,        "clock"        );
-    sc_trace( Debug::trace_file(), producedData, "producedData" );
-    sc_trace( Debug::trace_file(), expectedData, "expectedData" );
-    sc_trace( Debug::trace_file(), consumedData, "consumedData" );
-    sc_trace( Debug::trace_file(), produce,      "produce"      );
-    sc_trace( Debug::trace_file(), consume,      "consume"      );
-  }
+  Debug::trace( clock,        "clock",        this );
+  Debug::trace( producedData, "producedData", this );
+  Debug::trace( expectedData, "expectedData", this );
+  Debug::trace( consumedData, "consumedData", this );
+  Debug::trace( produce,      "produce",      this );
+  Debug::trace( consume,      "consume",      this );
 }//end start_of_simulation
 
 //------------------------------------------------------------------------------
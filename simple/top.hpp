@@ -2,7 +2,6 @@
 
 #include "test.hpp"
 #include "debug.hpp"
-#include "timer.hpp"
 #include <systemc>
 #include <string>
 using namespace std::literals;
@@ -32,20 +31,8 @@ SC_MODULE( Top_module ) {
     Debug::parse_command_line();
   }
 
-  void end_of_elaboration() override
-  {
-    Timer::global().report("Elaboration took");
-    Timer::global().reset();
-  }
-
-  void end_of_simulation() override
-  {
-    Timer::global().report("Simulation took");
-  }
-
   void start_of_simulation() override
   {
-    Timer::global().reset();
     Debug::stop_if_requested();
   }
 
@@ -1,6 +1,9 @@
 #include "consumer.hpp"
 #include "debug.hpp"
 #include "objection.hpp"
+#include "tx_recorder.hpp"
+#include "profiler.hpp"
+#include <vector>
 using namespace sc_core;
 using namespace std;
 using namespace std::literals;
@@ -19,15 +22,22 @@ Consumer_module::Consumer_module( const sc_core::sc_module_name& instance )
 void Consumer_module::consumer_thread()
 {
   auto dump = std::max( Debug::get_count("nDump"), size_t{0} );
-  if( Debug::tracing() ) {
-    sc_trace( Debug::trace_file(), m_rx, "m_rx" );
-  }
+  auto recorder = Debug::recorder();
+  auto channel = dynamic_cast<const sc_object*>( data_in.get_interface() ); // same stream as the producer
+  auto stream = ( recorder != nullptr and channel != nullptr ) ? recorder->stream( channel->name() ) : 0;
+
+  auto burst = std::max( Debug::get_count("nBurst"), size_t{1} ); // transactions per read
+  auto buffer = std::vector<Transaction>( burst );
 
   for(;;) {
-    auto rx = data_in->read();
-    m_rx.write( rx ); // for tracing
-    {
-      Objection consumer_objection{ name() };
+    PROFILE_ZONE( "consume" ); // spans wait(), see --fProfile
+    auto blocking = ( data_in->num_available() == 0 );
+    auto n = data_in.read_n( buffer.data(), buffer.size() );
+    if( blocking ) Debug::context_switch();
+    for( auto k = size_t{0}; k != n; ++k ) {
+      const auto& rx = buffer[k];
+      if( recorder != nullptr ) recorder->end( stream, rx.id() );
+      Objection::Scope consumer_objection{ m_busy };
       ++ m_received_count;
 
       // Dump a few transactions at the start 
@@ -35,7 +45,7 @@ void Consumer_module::consumer_thread()
       dump -= ( dump > 0 ) ? 1 : 0;
       SC_REPORT_INFO_VERB(
           msg_type,
-          ( "At "s + sc_time_stamp().to_string()
+          ( "At "s + Doulos::time_stamp()
             + " received " + rx.to_string()
           ).c_str(),
           dump_level
@@ -1,17 +1,19 @@
 #pragma once
 
 #include "transaction.hpp"
+#include "objection.hpp"
+#include "burst_fifo.hpp"
 #include <systemc>
 
 SC_MODULE( Consumer_module )
 {
   static constexpr const char* msg_type = "/Doulos/debugging_systemc/consumer";
-  sc_core::sc_fifo_in<Transaction> data_in{"data_in"};
+  Doulos::Burst_fifo_in<Transaction> data_in{"data_in"}; // an sc_fifo_in with read_n()
   explicit Consumer_module( const sc_core::sc_module_name& instance ); // Constructor
   size_t count() { return m_received_count; }
 private:
   [[maybe_unused]] void consumer_thread();
-  sc_core::sc_signal<Transaction> m_rx{};
+  Objection::Category m_busy{ name(), this }; //< raised while handling a transaction
   size_t m_received_count{0};
 };
 
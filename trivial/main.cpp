@@ -1,6 +1,6 @@
 #include "top.hpp"
-#include "timer.hpp"
 #include "debug.hpp"
+#include "profiler.hpp"
 #include <string>
 
 using namespace std::literals;
@@ -11,12 +11,18 @@ using namespace sc_core;
   constexpr const char* msg_type = "/Doulos/debugging_systemc/main";
 
   Top_module top { "top" };
-  Timer::global().report( "Construction" );
   sc_start();
 
   if ( not sc_end_of_simulation_invoked() ) {
     sc_stop();  // triggers end_of_simulation() callback
   }
 
+  if( Debug::parsed( "fProfile" ) and Debug::get_flag( "fProfile" ) ) {
+    Profiler::report();
+  }
+  else {
+    Profiler::set_report_at_exit( false );
+  }
+
   return Debug::exit_status( msg_type );
 }
@@ -1,7 +1,11 @@
 #include "producer.hpp"
 #include "debug.hpp"
 #include "objection.hpp"
+#include "tx_recorder.hpp"
+#include "burst_fifo.hpp"
+#include "profiler.hpp"
 #include <algorithm>
+#include <vector>
 using namespace sc_core;
 using namespace std;
 using namespace std::literals;
@@ -25,35 +29,48 @@ void Producer_module::producer_thread()
   auto dump = Debug::get_count("nDump");
   auto period = Debug::get_time("tPeriod");
   if( period == SC_ZERO_TIME ) period = sc_time{ 1, SC_NS };
-  if( Debug::tracing() ) {
-    sc_trace( Debug::trace_file(), m_tx, "m_tx" );
-  }
+  auto recorder = Debug::recorder();
+  auto stream = ( recorder != nullptr ) ? recorder->stream( fifo.name() ) : 0;
+
+  auto burst = std::max( Debug::get_count("nBurst"), size_t{1} ); // transactions per write
+  auto buffer = std::vector<Transaction>{};
+  buffer.reserve( burst );
 
   REPORT_ALWAYS( "reps="s + std::to_string(reps) );
   REPORT_ALWAYS( "dump="s + std::to_string(dump) );
   REPORT_ALWAYS( "period="s + period.to_string() );
+  if( burst > 1 ) REPORT_ALWAYS( "burst="s + std::to_string(burst) );
 
   Objection producer_objection{ name() };
 
-  for( auto i=0u; i != reps; ++i ) {
-    wait( period );
-    auto tx = m_tx.read();
-    tx.randomize();
-    m_tx.write(tx);
-    fifo.write( tx );
+  for( auto i=0u; i != reps; ) {
+    PROFILE_ZONE( "produce" ); // spans wait(), see --fProfile
+    // Same transactions at the same average rate, but one activation per burst
+    auto n = std::min<size_t>( burst, reps - i );
+    wait( period * static_cast<double>( n ) );
+    Debug::context_switch();
+    buffer.clear();
+    for( auto k=0u; k != n; ++k, ++i ) {
+      auto tx = Transaction::random(); // new id & random data
+      if( recorder != nullptr ) recorder->begin( stream, tx.id(), tx.data() );
+      buffer.push_back( tx );
+    }
+    Doulos::write_n( fifo, buffer.data(), buffer.size() );
     Debug::resume();
-    ++ m_transmit_count;
-
-    // Dump a few transactions at the start 
-    auto dump_level = ( dump > 0 and not Debug::debugging() ) ? SC_NONE : SC_DEBUG;
-    dump -= ( dump > 0 ) ? 1 : 0;
-    SC_REPORT_INFO_VERB(
-        msg_type,
-        ( "At "s + sc_time_stamp().to_string()
-          + " sent " + tx.to_string()
-        ).c_str(),
-        dump_level
-    );
+    m_transmit_count += n;
+
+    for( const auto& tx : buffer ) {
+      // Dump a few transactions at the start 
+      auto dump_level = ( dump > 0 and not Debug::debugging() ) ? SC_NONE : SC_DEBUG;
+      dump -= ( dump > 0 ) ? 1 : 0;
+      SC_REPORT_INFO_VERB(
+          msg_type,
+          ( "At "s + Doulos::time_stamp()
+            + " sent " + tx.to_string()
+          ).c_str(),
+          dump_level
+      );
+    }
   }
 
   wait( period );
@@ -16,7 +16,6 @@ SC_MODULE( Producer_module )
 private:
   [[maybe_unused]] void producer_thread();
   sc_core::sc_fifo<Transaction>   fifo{ depth };
-  sc_core::sc_signal<Transaction> m_tx{};
   size_t m_transmit_count{0};
 };
 
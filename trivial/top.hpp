@@ -3,9 +3,9 @@
 #include "producer.hpp"
 #include "consumer.hpp"
 #include "debug.hpp"
-#include "timer.hpp"
 #include "objection.hpp"
 #include <systemc>
+#include <chrono>
 #include <string>
 using namespace std::literals;
 
@@ -26,6 +26,7 @@ SC_MODULE( Top_module ) {
   {
     SC_HAS_PROCESS( Top_module );
     SC_THREAD( terminate_thread );
+    SC_THREAD( idle_thread );
 
     // Connectivity
     consumer.data_in.bind( producer.data_out );
@@ -43,19 +44,13 @@ SC_MODULE( Top_module ) {
     Debug::parse_command_line();
   }
 
-  void end_of_elaboration() override
-  {
-    Timer::global().report("Elaboration took");
-    Timer::global().reset();
-  }
-
   void start_of_simulation() override
   {
     Objection::set_drainTime( sc_core::sc_time{100, sc_core::SC_NS} );
     Objection::set_maxTimeout( sc_core::sc_time{100, sc_core::SC_MS} );
 
-    Timer::global().reset();
     Debug::stop_if_requested();
+    m_start = std::chrono::steady_clock::now();
     SC_REPORT_INFO_VERB(
       msg_type,
       ( std::string( 80, '-' ) + "\n"s
@@ -72,13 +67,16 @@ SC_MODULE( Top_module ) {
 
   void end_of_simulation() override
   {
-    Timer::global().report("Simulation took");
     if( consumer.count() == producer.count() ) {
       SC_REPORT_INFO_VERB( msg_type, "Transmit & receive transaction counts match", sc_core::SC_NONE );
     }
     else {
       SC_REPORT_ERROR( msg_type, "Transmit & receive transaction count mismatch" );
     }
+    auto wall = std::chrono::duration<double>( std::chrono::steady_clock::now() - m_start ).count();
+    auto rate = ( wall > 0 ) ? static_cast<size_t>( static_cast<double>( consumer.count() ) / wall ) : size_t{0};
+    REPORT_ALWAYS( std::to_string( Debug::context_switch(false) ) + " context switches, "s
+                 + std::to_string( rate ) + " transactions per second" );
   }
 
   void terminate_thread()
@@ -88,6 +86,33 @@ SC_MODULE( Top_module ) {
     Debug::stop_if_requested();
   }
 
+  // With --tIdle=TIME, report when the consumer has been idle for TIME
+  void idle_thread()
+  {
+    wait( sc_core::SC_ZERO_TIME ); // after parse_command_line()
+    if( not Debug::parsed( "tIdle" ) ) return;
+    auto idle = Debug::get_time( "tIdle" );
+    Objection::set_drainTime( &consumer, idle );
+    const auto& dropped = Objection::dropped_event( &consumer );
+    const auto& drained = Objection::drained_event( &consumer );
+    auto last_drop = sc_core::SC_ZERO_TIME;
+    for(;;) {
+      wait( dropped | drained );
+      if( dropped.triggered() ) last_drop = sc_core::sc_time_stamp();
+      if( not drained.triggered() ) continue;
+      auto idle_for = sc_core::sc_time_stamp() - last_drop;
+      if( idle_for < idle ) {
+        SC_REPORT_ERROR( msg_type, ( "Consumer drained after only "s + idle_for.to_string() ).c_str() );
+      }
+      else {
+        SC_REPORT_INFO_VERB( msg_type
+                           , ( "Consumer drained at "s + Doulos::time_stamp()
+                             + " (idle for "s + idle_for.to_string() + ")"s ).c_str()
+                           , sc_core::SC_NONE );
+      }
+    }
+  }
+
   // Destructor
   ~Top_module() override {
     // Report results of simulation
@@ -96,4 +121,6 @@ SC_MODULE( Top_module ) {
     }
   }
 
+private:
+  std::chrono::steady_clock::time_point m_start{};
 };
@@ -1,10 +1,16 @@
 #pragma once
 /// A simple transaction class with a unique id, a numeric data value, and a simple name.
+///
+/// Default construction is cheap (no id, no data) because sc_fifo and
+/// sc_signal default construct every slot and every read. Use
+/// Transaction::random() or Transaction{data} for a new transaction with an id.
+/// Ids are handed out to each OS thread in blocks, and random data comes from
+/// a counter-based generator (splitmix64), so both are thread-safe and cheap.
 
 #include <string>
+#include <atomic>
 #include <cstdint>
 #include <climits>
-#include <random>
 #include <ostream>
 #include <systemc>
 
@@ -16,9 +22,10 @@ struct Transaction
   static constexpr const Id_t BAD_ID{SIZE_MAX};
   using Data_t = int32_t;
 
-  // Constructor
+  // Constructors
   explicit Transaction( Data_t data ) : m_id{nextid()}, m_data{data} {}
-  Transaction() : m_id{nextid()}, m_data{} { randomize(); }
+  Transaction() = default; // BAD_ID & zero data (e.g., fifo slots)
+  [[nodiscard]] static Transaction random() { return Transaction{ random_data() }; } // new id & random data
 
   // Rule of zero
 
@@ -43,11 +50,10 @@ struct Transaction
   }
 
 
-  void randomize() {
-    static std::mt19937_64 gen{};
-    std::uniform_int_distribution<Data_t> dist;
-    m_data = dist(gen);
-  }
+  void randomize() { m_data = random_data(); }
+
+  // Restart the random data sequence (e.g., for a reproducible run)
+  static void seed( uint64_t value ) { s_random.store( value, std::memory_order_relaxed ); }
 
   // I/O support
   [[nodiscard]] std::string to_string() const {
@@ -67,7 +73,30 @@ struct Transaction
   }
 
 private:
-  static Id_t nextid() { static Id_t next{0}; return next++; }
-  Id_t   m_id;
-  Data_t m_data;
+  static constexpr Id_t id_block{ 1024 }; //< ids claimed at a time by each thread
+
+  static Id_t nextid()
+  {
+    thread_local Id_t next{ 0 }, last{ 0 };
+    if( next == last ) {
+      next = s_next_block.fetch_add( id_block, std::memory_order_relaxed );
+      last = next + id_block;
+    }
+    return next++;
+  }
+
+  // splitmix64: one atomic add per value, then a stateless mix; yields [0,INT32_MAX] as before
+  static Data_t random_data()
+  {
+    auto z = s_random.fetch_add( 0x9E3779B97F4A7C15ull, std::memory_order_relaxed ) + 0x9E3779B97F4A7C15ull;
+    z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+    z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+    z = z ^ ( z >> 31 );
+    return static_cast<Data_t>( z >> 33 );
+  }
+
+  inline static std::atomic<Id_t>     s_next_block{ 0 };
+  inline static std::atomic<uint64_t> s_random{ 0 };
+  Id_t   m_id{ BAD_ID };
+  Data_t m_data{};
 };